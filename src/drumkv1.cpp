@@ -22,6 +22,7 @@
 #include "drumkv1.h"
 
 #include "drumkv1_sample.h"
+#include "drumkv1_sample_cache.h"
 
 #include "drumkv1_wave.h"
 #include "drumkv1_ramp.h"
@@ -34,6 +35,11 @@
 #include "drumkv1_fx.h"
 #include "drumkv1_reverb.h"
 
+#include "drumkv1_simd.h"
+#include "drumkv1_fastmath.h"
+
+#include "drumkv1_worker.h"
+
 #include "drumkv1_config.h"
 #include "drumkv1_controls.h"
 #include "drumkv1_programs.h"
@@ -41,6 +47,8 @@
 
 #include "drumkv1_sched.h"
 
+#include "drumkv1_rtcheck.h"
+
 
 #ifdef CONFIG_DEBUG_0
 #include <stdio.h>
@@ -48,6 +56,8 @@
 
 #include <string.h>
 
+#include <atomic>
+
 
 //-------------------------------------------------------------------------
 // drumkv1_impl
@@ -56,7 +66,9 @@
 //    Copyright (C) 2007 jorgen, linux-vst.com
 //
 
-const uint8_t MAX_VOICES  = 64;			// max polyphony
+const uint16_t MIN_VOICES = 8;			// min polyphony
+const uint16_t DEF_VOICES = 64;			// default polyphony
+const uint16_t MAX_VOICES = 1024;		// max polyphony
 const uint8_t MAX_NOTES   = 128;
 const uint8_t MAX_GROUP   = 128;
 
@@ -68,7 +80,18 @@ const float FINE_SCALE    = 1.0f;
 const float SWEEP_SCALE   = 0.5f;
 const float PITCH_SCALE   = 0.5f;
 
-const uint8_t MAX_DIRECT_NOTES = (MAX_VOICES >> 2);
+const float STEAL_FADE_MSECS = 5.0f;	// voice-stealing fade-out time
+
+const float DEF_SILENCE_DB = -96.0f;	// default silence threshold
+const float MIN_SILENCE_DB = -144.0f;	// below this, silence detection is off
+
+const uint8_t MAX_DIRECT_NOTES = (DEF_VOICES >> 2);
+
+const uint32_t MAX_VOICE_BLOCK = 64;	// max staged voice render block
+
+const uint32_t DEF_BUFFER_SIZE = 1024;	// default (preallocated) block size
+
+const int MAX_VOICE_THREADS = 8;		// max voice render worker threads
 
 
 // maximum helper
@@ -133,7 +156,7 @@ inline float drumkv1_pow2f ( const float x )
 // simplest power-of-2 straight linearization
 // -- x argument valid in [-1, 1] interval
 //	return 1.0f + (x < 0.0f ? 0.5f : 1.0f) * x;
-	return ::powf(2.0f, x);
+	return drumkv1_exp2f(x);
 }
 
 
@@ -141,7 +164,7 @@ inline float drumkv1_pow2f ( const float x )
 
 inline float drumkv1_freq2 ( float delta )
 {
-	return ::powf(2.0f, delta / 12.0f);
+	return drumkv1_exp2f(delta / 12.0f);
 }
 
 inline float drumkv1_freq ( int note )
@@ -725,7 +748,7 @@ protected:
 		const float wbal = 0.25f * M_PI
 			* (1.0f + m_param1_v);
 
-		return M_SQRT2 * (i & 1 ? ::sinf(wbal) : ::cosf(wbal));
+		return M_SQRT2 * (i & 1 ? drumkv1_sinf(wbal) : drumkv1_cosf(wbal));
 	}
 };
 
@@ -748,7 +771,7 @@ protected:
 			* (1.0f + m_param1_v)
 			* (1.0f + m_param2_v);
 
-		return M_SQRT2 * (i & 1 ? ::sinf(wbal) : ::cosf(wbal));
+		return M_SQRT2 * (i & 1 ? drumkv1_sinf(wbal) : drumkv1_cosf(wbal));
 	}
 };
 
@@ -829,6 +852,11 @@ public:
 
 	float params[3][drumkv1::NUM_ELEMENT_PARAMS];
 
+	float silence1_db;							// silence threshold (dBFS)
+	float silence1_level;						// silence threshold (linear)
+
+	void setSilenceThreshold(float db);
+
 	void updateEnvTimes(float srate);
 };
 
@@ -852,6 +880,9 @@ drumkv1_elem::drumkv1_elem ( drumkv1 *pDrumk, float srate, int key )
 	// max env. stage length (default)
 	gen1.envtime0 = 0.0001f * MAX_ENV_MSECS;
 
+	// voice silence threshold (default)
+	setSilenceThreshold(DEF_SILENCE_DB);
+
 	for (int j = 0; j < 3; ++j) {
 		params[j][drumkv1::GEN1_SAMPLE]  = gen1.sample0;
 		params[j][drumkv1::GEN1_ENVTIME] = gen1.envtime0;
@@ -867,6 +898,18 @@ drumkv1_elem::drumkv1_elem ( drumkv1 *pDrumk, float srate, int key )
 }
 
 
+void drumkv1_elem::setSilenceThreshold ( float db )
+{
+	if (db > 0.0f)
+		db = 0.0f;
+	if (db < MIN_SILENCE_DB)
+		db = MIN_SILENCE_DB;
+
+	silence1_db = db;
+	silence1_level = (db > MIN_SILENCE_DB ? ::powf(10.0f, 0.05f * db) : 0.0f);
+}
+
+
 void drumkv1_elem::updateEnvTimes ( float srate )
 {
 	// element envelope range times in frames
@@ -909,6 +952,15 @@ struct drumkv1_voice : public drumkv1_list<drumkv1_voice>
 	{
 		elem = pElem;
 
+		fade1_frames = 0;
+		fade1_delta = 0.0f;
+
+		silence1_peak = 0.0f;
+		silence1_frames = 0;
+		silence1_armed = false;
+
+		render1 = -1;
+
 		gen1.reset(pElem ? &pElem->gen1_sample : nullptr);
 		lfo1.reset(pElem ? &pElem->lfo1_wave : nullptr);
 
@@ -947,6 +999,15 @@ struct drumkv1_voice : public drumkv1_list<drumkv1_voice>
 
 	drumkv1_bal1  out1_pan;						// output panning
 	drumkv1_ramp1 out1_vol;						// output volume
+
+	uint32_t fade1_frames;						// voice-stealing fade-out
+	float    fade1_delta;
+
+	float    silence1_peak;						// output peak tracker
+	uint32_t silence1_frames;					// frames below threshold
+	bool     silence1_armed;					// output was audible once
+
+	int render1;								// render kernel index
 };
 
 
@@ -1019,6 +1080,9 @@ public:
 	void setBufferSize(uint32_t nsize);
 	uint32_t bufferSize() const;
 
+	void setNominalBufferSize(uint32_t nsize);
+	uint32_t nominalBufferSize() const;
+
 	drumkv1_element *addElement(int key);
 	drumkv1_element *element(int key) const;
 	void removeElement(int key);
@@ -1049,6 +1113,12 @@ public:
 	void setTempo(float bpm);
 	float tempo() const;
 
+	void setPolyphony(int nvoices);
+	uint16_t polyphony() const;
+
+	void setVoiceSteal(drumkv1::VoiceSteal steal);
+	drumkv1::VoiceSteal voiceSteal() const;
+
 	void setParamPort(drumkv1::ParamIndex index, float *pfParam);
 	drumkv1_port *paramPort(drumkv1::ParamIndex index);
 
@@ -1076,7 +1146,20 @@ public:
 	void resetTuning();
 
 	void process_midi(uint8_t *data, uint32_t size);
-	void process(float **ins, float **outs, uint32_t nframes);
+	void process(float **ins, float **outs, uint32_t nframes,
+		const drumkv1::MidiEvent *events = nullptr, uint32_t nevents = 0);
+
+	void process_block(float **ins, float **outs, uint32_t nframes,
+		const drumkv1::MidiEvent *events, uint32_t nevents, uint32_t noffset);
+
+	void render_work(uint16_t islot);
+
+	void process_fx(float **sfxs, uint32_t nframes, bool limiter);
+	void process_fx_pipe(float **outs, uint32_t nframes, bool limiter);
+	void process_dry(float **outs, uint32_t nframes, bool limiter);
+	void fx_work();
+
+	uint32_t latency() const;
 
 	void resetParamValues(bool bSwap);
 
@@ -1115,7 +1198,11 @@ protected:
 		drumkv1_voice *pv = nullptr;
 		drumkv1_elem *elem = m_elems[key];
 		if (elem) {
+			if (m_nvoices - m_nfades >= m_polyphony)
+				steal_voice(elem);
 			pv = m_free_list.next();
+			if (pv == nullptr)
+				pv = kill_voice();
 			if (pv) {
 				pv->reset(elem);
 				m_free_list.remove(pv);
@@ -1128,13 +1215,56 @@ protected:
 
 	void free_voice ( drumkv1_voice *pv )
 	{
+		if (pv->fade1_delta > 0.0f)
+			--m_nfades;
 		m_play_list.remove(pv);
 		m_free_list.append(pv);
 		pv->reset(0);
 		--m_nvoices;
 	}
 
+	void steal_voice(drumkv1_elem *elem);
+	drumkv1_voice *kill_voice();
+
+	void alloc_voices(uint16_t nvoices);
+
 	void alloc_sfxs(uint32_t nsize);
+	void reset_fx_ring();
+
+	// staged voice render scratch buffers
+	struct voice_block
+	{
+		float gen1[MAX_VOICE_BLOCK];
+		float gen2[MAX_VOICE_BLOCK];
+		float vel1[MAX_VOICE_BLOCK];
+		float lfo1[MAX_VOICE_BLOCK];
+		float cut1[MAX_VOICE_BLOCK];
+		float res1[MAX_VOICE_BLOCK];
+		float wid1[MAX_VOICE_BLOCK];
+		float pan1[MAX_VOICE_BLOCK];
+		float pan2[MAX_VOICE_BLOCK];
+	};
+
+	bool process_voice(drumkv1_voice *pv, float **outs, float **sfxs,
+		uint32_t noffset, uint32_t nframes, voice_block *vb);
+
+	void render_voices(float **outs, uint32_t noffset, uint32_t nframes);
+
+#ifdef CONFIG_VOICE_BLOCK
+	// specialized voice render kernels
+	template <int Slope, bool Lfo, bool Dca, bool Stereo>
+	void render_voice(drumkv1_voice *pv,
+		float **v_outs, float **v_sfxs, uint32_t n0, uint32_t j0,
+		uint32_t nframes, voice_block *vb);
+
+	typedef void (drumkv1_impl::*RenderFunc)(drumkv1_voice *pv,
+		float **v_outs, float **v_sfxs, uint32_t n0, uint32_t j0,
+		uint32_t nframes, voice_block *vb);
+
+	static const RenderFunc g_render_funcs[];
+
+	static int render_kernel(drumkv1_elem *elem);
+#endif
 
 private:
 
@@ -1164,6 +1294,14 @@ private:
 	drumkv1_dyn m_dyn;
 
 	drumkv1_voice **m_voices;
+	uint16_t        m_nvoices_pool;
+	uint16_t        m_polyphony;
+
+	drumkv1::VoiceSteal m_steal;
+	uint32_t            m_steal_frames;
+
+	float    m_silence_msecs;
+	uint32_t m_silence_frames;
 	drumkv1_voice  *m_notes[MAX_NOTES];
 	drumkv1_voice  *m_group[MAX_GROUP];
 
@@ -1185,11 +1323,56 @@ private:
 	float  **m_sfxs;
 	uint32_t m_nsize;
 
+	// multi-core voice rendering
+	drumkv1_worker *m_worker;
+
+	struct render_slot
+	{
+		render_slot() : outs(nullptr), sfxs(nullptr), active(false) {}
+
+		voice_block vblock;
+		float **outs;
+		float **sfxs;
+		bool active;
+	};
+
+	render_slot *m_slots;
+
+	drumkv1_voice **m_render_voices;
+	bool           *m_render_over;
+
+	uint32_t m_render_nvoices;
+	uint32_t m_render_noffset;
+	uint32_t m_render_nframes;
+	float  **m_render_outs;
+	float  **m_render_sfxs;
+
+	std::atomic<uint32_t> m_render_index;
+
+	// pipelined effects (dedicated thread)
+	drumkv1_worker *m_fx_worker;
+
+	float  **m_fx_sfxs;
+	uint32_t m_fx_nframes;
+	bool     m_fx_limiter;
+
+	float  **m_fx_ring;
+	uint32_t m_fx_ring_r;
+	uint32_t m_fx_ring_w;
+	uint32_t m_fx_nsize;
+	uint32_t m_fx_nominal;
+
+	// dry path (limiter lookahead) latency compensation
+	float  **m_dry_ring;
+	uint32_t m_dry_ring_w;
+	uint32_t m_dry_delay;
+
 	drumkv1_fx_chorus   m_chorus;
 	drumkv1_fx_flanger *m_flanger;
 	drumkv1_fx_phaser  *m_phaser;
 	drumkv1_fx_delay   *m_delay;
-	drumkv1_fx_comp    *m_comp;
+	drumkv1_fx_comp     m_comp;
+	drumkv1_fx_limiter  m_limiter;
 
 	drumkv1_reverb m_reverb;
 
@@ -1201,6 +1384,7 @@ private:
 	} m_direct_notes[MAX_DIRECT_NOTES];
 
 	volatile int  m_nvoices;
+	volatile int  m_nfades;
 
 	volatile bool m_running;
 };
@@ -1214,13 +1398,47 @@ drumkv1_impl::drumkv1_impl (
 		m_midi_in(pDrumk), m_bpm(180.0f), m_running(false)
 {
 	// allocate voice pool.
-	m_voices = new drumkv1_voice * [MAX_VOICES];
+	m_voices = nullptr;
+	m_nvoices_pool = 0;
+	m_polyphony = 0;
+
+	m_render_voices = nullptr;
+	m_render_over = nullptr;
 
-	for (int i = 0; i < MAX_VOICES; ++i) {
-		m_voices[i] = new drumkv1_voice();
-		m_free_list.append(m_voices[i]);
+	m_nvoices = 0;
+	m_nfades = 0;
+
+	// decoded sample cache (on disk).
+	if (m_config.bSampleCache) {
+		drumkv1_sample_cache::setup(
+			m_config.sSampleCacheDir.toUtf8().constData(),
+			m_config.iSampleCacheSize > 0 ? m_config.iSampleCacheSize : 0);
+	} else {
+		drumkv1_sample_cache::setup(nullptr, 0);
 	}
 
+	// disk-streaming of long samples (from the cache).
+	drumkv1_sample_pool::setStreaming(
+		m_config.bSampleCache && m_config.bSampleStreaming);
+
+	// sample-rate conversion quality (on decode).
+	drumkv1_sample_pool::setResampleQuality(m_config.iResampleQuality);
+
+	// resident sample frames format (compact: int16 or half-float).
+	drumkv1_sample_pool::setSampleFormat(m_config.iSampleFormat);
+
+	// page-locked (and prefaulted) resident sample frames.
+	drumkv1_sample_pool::setLocking(m_config.bSampleLock);
+
+	setPolyphony(m_config.iPolyphony);
+	setVoiceSteal(drumkv1::VoiceSteal(m_config.iVoiceSteal));
+
+	// silent voice retirement hold time (0=off).
+	m_silence_msecs = float(m_config.iSilenceHold);
+	if (m_silence_msecs < 0.0f)
+		m_silence_msecs = 0.0f;
+	m_silence_frames = 0;
+
 	for (int note = 0; note < MAX_NOTES; ++note)
 		m_notes[note] = nullptr;
 
@@ -1234,6 +1452,41 @@ drumkv1_impl::drumkv1_impl (
 	// special case for sample element switching
 	m_key = new drumkv1_port();
 
+	// multi-core voice rendering, if any...
+	int nthreads = m_config.iVoiceThreads;
+	if (nthreads > MAX_VOICE_THREADS)
+		nthreads = MAX_VOICE_THREADS;
+	if (nthreads < 0)
+		nthreads = 0;
+	m_worker = new drumkv1_worker(nthreads);
+	m_slots = new render_slot [m_worker->slots()];
+
+	m_render_nvoices = 0;
+	m_render_noffset = 0;
+	m_render_nframes = 0;
+	m_render_outs = nullptr;
+	m_render_sfxs = nullptr;
+	m_render_index = 0;
+
+	// pipelined effects, if any...
+	m_fx_worker = nullptr;
+	if (m_config.bEffectsThread)
+		m_fx_worker = new drumkv1_worker(1);
+
+	m_fx_sfxs = nullptr;
+	m_fx_nframes = 0;
+	m_fx_limiter = false;
+
+	m_fx_ring = nullptr;
+	m_fx_ring_r = 0;
+	m_fx_ring_w = 0;
+	m_fx_nsize = 0;
+	m_fx_nominal = 0;
+
+	m_dry_ring = nullptr;
+	m_dry_ring_w = 0;
+	m_dry_delay = 0;
+
 	// local buffers none yet
 	m_sfxs = nullptr;
 	m_nsize = 0;
@@ -1247,9 +1500,6 @@ drumkv1_impl::drumkv1_impl (
 	// delays none yet
 	m_delay = nullptr;
 
-	// compressors none yet
-	m_comp = nullptr;
-
 	// Micro-tuning support, if any...
 	resetTuning();
 
@@ -1260,6 +1510,9 @@ drumkv1_impl::drumkv1_impl (
 	// number of channels
 	setChannels(nchannels);
 
+	// local buffers (default size, until negotiated)
+	alloc_sfxs(DEF_BUFFER_SIZE);
+
 	// set default sample rate
 	setSampleRate(srate);
 
@@ -1291,14 +1544,20 @@ drumkv1_impl::~drumkv1_impl (void)
 	delete m_key;
 
 	// deallocate voice pool.
-	for (int i = 0; i < MAX_VOICES; ++i)
-		delete m_voices[i];
-
-	delete [] m_voices;
+	allNotesOff();
+	alloc_voices(0);
 
 	// deallocate local buffers
 	alloc_sfxs(0);
 
+	// stop multi-core voice rendering
+	delete [] m_slots;
+	delete m_worker;
+
+	// stop pipelined effects
+	if (m_fx_worker)
+		delete m_fx_worker;
+
 	// deallocate channels
 	setChannels(0);
 
@@ -1328,12 +1587,6 @@ void drumkv1_impl::setChannels ( uint16_t nchannels )
 		delete [] m_delay;
 		m_delay = nullptr;
 	}
-
-	// deallocate compressors
-	if (m_comp) {
-		delete [] m_comp;
-		m_comp = nullptr;
-	}
 }
 
 
@@ -1347,6 +1600,14 @@ void drumkv1_impl::setSampleRate ( float srate )
 {
 	// set internal sample rate
 	m_srate = srate;
+
+	// voice-stealing fade-out length
+	m_steal_frames = uint32_t(0.001f * STEAL_FADE_MSECS * m_srate);
+	if (m_steal_frames < 1)
+		m_steal_frames = 1;
+
+	// silent voice retirement hold time
+	m_silence_frames = uint32_t(0.001f * m_silence_msecs * m_srate);
 }
 
 
@@ -1358,7 +1619,7 @@ float drumkv1_impl::sampleRate (void) const
 
 void drumkv1_impl::setBufferSize ( uint32_t nsize )
 {
-	// set nominal buffer size
+	// set maximum buffer size (never shrinks; not real-time safe)
 	if (m_nsize < nsize) alloc_sfxs(nsize);
 }
 
@@ -1369,6 +1630,52 @@ uint32_t drumkv1_impl::bufferSize (void) const
 }
 
 
+void drumkv1_impl::setNominalBufferSize ( uint32_t nsize )
+{
+	// set nominal (host) block size (not real-time safe)
+	if (m_nsize < nsize) alloc_sfxs(nsize);
+
+	m_fx_nominal = nsize;
+
+	// pipelined effects latency ring (re)sizing...
+	if (m_fx_worker) {
+		m_fx_worker->wait();
+		m_fx_nframes = 0;
+		reset_fx_ring();
+	}
+}
+
+
+uint32_t drumkv1_impl::nominalBufferSize (void) const
+{
+	return m_fx_nominal;
+}
+
+
+uint32_t drumkv1_impl::latency (void) const
+{
+	// pipelined effects (wet path only) and limiter lookahead latency,
+	// as compensated on the dry path (current block).
+	return (m_fx_worker ? m_fx_nsize : 0) + m_dry_delay;
+}
+
+
+// pipelined effects latency ring: one nominal block,
+// or the preallocated buffer size, if unknown or larger.
+void drumkv1_impl::reset_fx_ring (void)
+{
+	m_fx_nsize = m_nsize;
+	if (m_fx_nominal > 0 && m_fx_nominal < m_nsize)
+		m_fx_nsize = m_fx_nominal;
+
+	for (uint16_t k = 0; m_fx_ring && k < m_nchannels; ++k)
+		::memset(m_fx_ring[k], 0, m_nsize * sizeof(float));
+
+	m_fx_ring_r = 0;
+	m_fx_ring_w = 0;
+}
+
+
 void drumkv1_impl::setTempo ( float bpm )
 {
 	// set nominal tempo (BPM)
@@ -1382,14 +1689,217 @@ float drumkv1_impl::tempo (void) const
 }
 
 
+// polyphony (voice pool size; not while processing)
+void drumkv1_impl::setPolyphony ( int npolyphony )
+{
+	// clamp before narrowing (command line, config or host option).
+	uint16_t nvoices = DEF_VOICES;
+	if (npolyphony > 0) {
+		if (npolyphony < int(MIN_VOICES))
+			nvoices = MIN_VOICES;
+		else
+		if (npolyphony > int(MAX_VOICES))
+			nvoices = MAX_VOICES;
+		else
+			nvoices = uint16_t(npolyphony);
+	}
+
+	if (m_voices && m_polyphony == nvoices)
+		return;
+
+	const bool running = drumkv1_impl::running(false);
+
+	allNotesOff();
+	alloc_voices(nvoices);
+
+	drumkv1_impl::running(running);
+}
+
+
+uint16_t drumkv1_impl::polyphony (void) const
+{
+	return m_polyphony;
+}
+
+
+// voice-stealing policy
+void drumkv1_impl::setVoiceSteal ( drumkv1::VoiceSteal steal )
+{
+	if (steal < drumkv1::StealOldest || steal > drumkv1::StealElement)
+		steal = drumkv1::StealOldest;
+
+	m_steal = steal;
+}
+
+
+drumkv1::VoiceSteal drumkv1_impl::voiceSteal (void) const
+{
+	return m_steal;
+}
+
+
+// (re)allocate voice pool
+void drumkv1_impl::alloc_voices ( uint16_t nvoices )
+{
+	if (m_voices) {
+		for (uint16_t i = 0; i < m_nvoices_pool; ++i) {
+			drumkv1_sample_stream *stream = m_voices[i]->gen1.stream();
+			m_free_list.remove(m_voices[i]);
+			delete m_voices[i];
+			if (stream)
+				delete stream;
+		}
+		delete [] m_voices;
+		delete [] m_render_voices;
+		delete [] m_render_over;
+		m_voices = nullptr;
+		m_render_voices = nullptr;
+		m_render_over = nullptr;
+		m_nvoices_pool = 0;
+		m_polyphony = 0;
+	}
+
+	if (nvoices > 0) {
+		// extra voices reserved for stolen ones fading out
+		uint16_t nfades = (nvoices >> 2);
+		if (nfades < 4)
+			nfades = 4;
+		m_polyphony = nvoices;
+		m_nvoices_pool = nvoices + nfades;
+		const bool streaming = drumkv1_sample_pool::isStreaming();
+		m_voices = new drumkv1_voice * [m_nvoices_pool];
+		for (uint16_t i = 0; i < m_nvoices_pool; ++i) {
+			m_voices[i] = new drumkv1_voice();
+			if (streaming)
+				m_voices[i]->gen1.setStream(new drumkv1_sample_stream());
+			m_free_list.append(m_voices[i]);
+		}
+		m_render_voices = new drumkv1_voice * [m_nvoices_pool];
+		m_render_over = new bool [m_nvoices_pool];
+	}
+
+	m_nvoices = 0;
+	m_nfades = 0;
+}
+
+
+// voice-stealing: pick a victim and fade it out
+void drumkv1_impl::steal_voice ( drumkv1_elem *elem )
+{
+	drumkv1_voice *pv_steal = nullptr;
+	float level_steal = 0.0f;
+
+	drumkv1_voice *pv = m_play_list.next();
+	while (pv) {
+		if (pv->fade1_delta > 0.0f) {
+			pv = pv->next();
+			continue;
+		}
+		if (m_steal == drumkv1::StealQuietest) {
+			const float level = pv->vel * (*pv->elem->dca1.enabled > 0.0f
+				? pv->dca1_env.value : 1.0f);
+			if (pv_steal == nullptr || level_steal > level) {
+				pv_steal = pv;
+				level_steal = level;
+			}
+		}
+		else
+		if (m_steal == drumkv1::StealElement) {
+			if (pv_steal == nullptr)
+				pv_steal = pv; // oldest, as fallback
+			if (pv->elem == elem) {
+				pv_steal = pv;
+				break;
+			}
+		}
+		else { // drumkv1::StealOldest
+			pv_steal = pv;
+			break;
+		}
+		pv = pv->next();
+	}
+
+	if (pv_steal == nullptr)
+		return;
+
+	// release note and group, then fade-out
+	if (pv_steal->note >= 0 && m_notes[pv_steal->note] == pv_steal)
+		m_notes[pv_steal->note] = nullptr;
+	if (pv_steal->group >= 0 && m_group[pv_steal->group] == pv_steal)
+		m_group[pv_steal->group] = nullptr;
+
+	pv_steal->note = -1;
+	pv_steal->group = -1;
+
+	pv_steal->fade1_frames = m_steal_frames;
+	pv_steal->fade1_delta = 1.0f / float(m_steal_frames);
+
+	++m_nfades;
+}
+
+
+// voice-stealing: no free voices, cut the oldest fading one
+drumkv1_voice *drumkv1_impl::kill_voice (void)
+{
+	drumkv1_voice *pv = m_play_list.next();
+	while (pv && !(pv->fade1_delta > 0.0f))
+		pv = pv->next();
+
+	if (pv == nullptr)
+		pv = m_play_list.next();
+
+	if (pv) {
+		if (pv->note >= 0 && m_notes[pv->note] == pv)
+			m_notes[pv->note] = nullptr;
+		if (pv->group >= 0 && m_group[pv->group] == pv)
+			m_group[pv->group] = nullptr;
+		free_voice(pv);
+		pv = m_free_list.next();
+	}
+
+	return pv;
+}
+
+
 // allocate local buffers
 void drumkv1_impl::alloc_sfxs ( uint32_t nsize )
 {
+	// join pipelined effects, if any...
+	if (m_fx_worker) {
+		m_fx_worker->wait();
+		m_fx_nframes = 0;
+	}
+
 	if (m_sfxs) {
 		for (uint16_t k = 0; k < m_nchannels; ++k)
 			delete [] m_sfxs[k];
 		delete [] m_sfxs;
 		m_sfxs = nullptr;
+		for (uint16_t k = 0; k < m_nchannels; ++k)
+			delete [] m_dry_ring[k];
+		delete [] m_dry_ring;
+		m_dry_ring = nullptr;
+		if (m_fx_sfxs) {
+			for (uint16_t k = 0; k < m_nchannels; ++k) {
+				delete [] m_fx_sfxs[k];
+				delete [] m_fx_ring[k];
+			}
+			delete [] m_fx_sfxs;
+			delete [] m_fx_ring;
+			m_fx_sfxs = nullptr;
+			m_fx_ring = nullptr;
+		}
+		for (uint16_t i = 1; i < m_worker->slots(); ++i) {
+			render_slot& slot = m_slots[i];
+			for (uint16_t k = 0; k < m_nchannels; ++k) {
+				delete [] slot.sfxs[k];
+				delete [] slot.outs[k];
+			}
+			delete [] slot.sfxs;
+			delete [] slot.outs;
+			slot.sfxs = nullptr;
+			slot.outs = nullptr;
+		}
 		m_nsize = 0;
 	}
 
@@ -1398,6 +1908,32 @@ void drumkv1_impl::alloc_sfxs ( uint32_t nsize )
 		m_sfxs = new float * [m_nchannels];
 		for (uint16_t k = 0; k < m_nchannels; ++k)
 			m_sfxs[k] = new float [m_nsize];
+		const uint32_t ndry = drumkv1_fx_limiter::MAX_LOOKAHEAD;
+		m_dry_ring = new float * [m_nchannels];
+		for (uint16_t k = 0; k < m_nchannels; ++k) {
+			m_dry_ring[k] = new float [ndry];
+			::memset(m_dry_ring[k], 0, ndry * sizeof(float));
+		}
+		m_dry_ring_w = 0;
+		m_dry_delay = 0;
+		for (uint16_t i = 1; i < m_worker->slots(); ++i) {
+			render_slot& slot = m_slots[i];
+			slot.outs = new float * [m_nchannels];
+			slot.sfxs = new float * [m_nchannels];
+			for (uint16_t k = 0; k < m_nchannels; ++k) {
+				slot.outs[k] = new float [m_nsize];
+				slot.sfxs[k] = new float [m_nsize];
+			}
+		}
+		if (m_fx_worker) {
+			m_fx_sfxs = new float * [m_nchannels];
+			m_fx_ring = new float * [m_nchannels];
+			for (uint16_t k = 0; k < m_nchannels; ++k) {
+				m_fx_sfxs[k] = new float [m_nsize];
+				m_fx_ring[k] = new float [m_nsize];
+			}
+			reset_fx_ring();
+		}
 	}
 }
 
@@ -1538,8 +2074,7 @@ void drumkv1_impl::clearElements (void)
 
 void drumkv1_impl::setSampleFile ( const char *pszSampleFile )
 {
-	reset();
-
+	// sample data gets swapped atomically, no need to reset...
 	if (m_elem) m_elem->element.setSampleFile(pszSampleFile);
 }
 
@@ -1781,6 +2316,10 @@ void drumkv1_impl::process_midi ( uint8_t *data, uint32_t size )
 					&m_ctl.pressure, &pv->pre);
 				// generate
 				pv->gen1.start();
+			#ifdef CONFIG_VOICE_BLOCK
+				// render kernel
+				pv->render1 = render_kernel(elem);
+			#endif
 				// frequencies
 				const float gen1_tuning
 					= *elem->gen1.coarse * COARSE_SCALE
@@ -1927,19 +2466,37 @@ void drumkv1_impl::allControllersOff (void)
 
 void drumkv1_impl::allSoundOff (void)
 {
+	// join pipelined effects (previous block) before touching
+	// any of their state; silence whatever is still pending...
+	if (m_fx_worker) {
+		m_fx_worker->wait();
+		for (uint16_t k = 0; m_fx_sfxs && k < m_nchannels; ++k) {
+			::memset(m_fx_sfxs[k], 0, m_fx_nframes * sizeof(float));
+			::memset(m_fx_ring[k], 0, m_nsize * sizeof(float));
+		}
+	}
+
 	m_chorus.setSampleRate(m_srate);
 	m_chorus.reset();
 
 	for (uint16_t k = 0; k < m_nchannels; ++k) {
 		m_phaser[k].setSampleRate(m_srate);
 		m_delay[k].setSampleRate(m_srate);
-		m_comp[k].setSampleRate(m_srate);
 		m_flanger[k].reset();
 		m_phaser[k].reset();
 		m_delay[k].reset();
-		m_comp[k].reset();
 	}
 
+	m_comp.setSampleRate(m_srate);
+	m_comp.reset();
+
+	m_limiter.setSampleRate(m_srate);
+	m_limiter.reset();
+
+	for (uint16_t k = 0; m_dry_ring && k < m_nchannels; ++k)
+		::memset(m_dry_ring[k], 0, m_dry_delay * sizeof(float));
+	m_dry_ring_w = 0;
+
 	m_reverb.setSampleRate(m_srate);
 	m_reverb.reset();
 }
@@ -2157,10 +2714,6 @@ void drumkv1_impl::reset (void)
 	if (m_delay == nullptr)
 		m_delay = new drumkv1_fx_delay [m_nchannels];
 
-	// compressors
-	if (m_comp == nullptr)
-		m_comp = new drumkv1_fx_comp [m_nchannels];
-
 	// reverbs
 	m_reverb.reset();
 
@@ -2188,264 +2741,657 @@ uint32_t drumkv1_impl::midiInCount (void)
 
 // synthesize
 
-void drumkv1_impl::process ( float **ins, float **outs, uint32_t nframes )
+#ifdef CONFIG_VOICE_BLOCK
+
+// staged block voice render:
+// generator fill, filter, envelope/gain and pan/width mix-down stages;
+// specialized on filter slope (-1=off), LFO, DCA and stereo sample;
+// n0 is the element (block) ramps offset, j0 the voice ramps one.
+template <int Slope, bool Lfo, bool Dca, bool Stereo>
+void drumkv1_impl::render_voice ( drumkv1_voice *pv,
+	float **v_outs, float **v_sfxs, uint32_t n0, uint32_t j0,
+	uint32_t nframes, voice_block *vb )
 {
-	if (!m_running) return;
+	drumkv1_elem *elem = pv->elem;
 
-	float *v_outs[m_nchannels];
-	float *v_sfxs[m_nchannels];
+	const float lfo1_freq = (Lfo
+		? get_bpm(*elem->lfo1.bpm) / (60.01f - *elem->lfo1.rate * 60.0f) : 0.0f);
 
-	// FIXME: fx-send buffer reallocation... seriously?
-	if (m_nsize < nframes) alloc_sfxs(nframes);
+	const float modwheel1 = (Lfo
+		? m_ctl.modwheel + PITCH_SCALE * *elem->lfo1.pitch : 0.0f);
 
-	uint16_t k;
+	const float fxsend1	= *elem->out1.fxsend * *elem->out1.fxsend;
 
-	for (k = 0; k < m_nchannels; ++k) {
-		::memset(m_sfxs[k], 0, nframes * sizeof(float));
-		::memcpy(outs[k], ins[k], nframes * sizeof(float));
-	}
+	float *gen1 = vb->gen1;
+	float *gen2 = vb->gen2;
+	float *vel1 = vb->vel1;
+	float *lfo1 = vb->lfo1;
 
-	// process direct note on/off...
-	while (m_direct_note > 0) {
-		const direct_note& data
-			= m_direct_notes[--m_direct_note];
-		process_midi((uint8_t *) &data, sizeof(data));
+	uint32_t j;
+
+	// generators (and velocities)
+
+	for (j = 0; j < nframes; ++j) {
+
+		vel1[j] = (pv->vel + (1.0f - pv->vel) * pv->dca1_pre.value(j0 + j));
+
+		if (Lfo) {
+			const float lfo1_env = pv->lfo1_env.tick();
+			lfo1[j] = pv->lfo1_sample * lfo1_env;
+			pv->gen1.next(pv->gen1_freq
+				* (m_ctl.pitchbend + modwheel1 * lfo1[j]));
+			pv->lfo1_sample = pv->lfo1.sample(lfo1_freq
+				* (1.0f + SWEEP_SCALE * *elem->lfo1.sweep * lfo1_env));
+		} else {
+			pv->gen1.next(pv->gen1_freq * m_ctl.pitchbend);
+		}
+
+		gen1[j] = pv->gen1.value(0);
+		if (Stereo)
+			gen2[j] = pv->gen1.value(1);
 	}
 
-	drumkv1_elem *elem = m_elem_list.next();
-	while (elem) {
-	#if 0
-		if (elem->gen1.sample0 != *elem->gen1.sample) {
-			elem->gen1.sample0  = *elem->gen1.sample;
-			elem->gen1_sample.reset(note_freq(elem->gen1.sample0));
+	if (j0 == 0) {
+		if (Lfo) {
+			pv->out1_panning = lfo1[0] * *elem->lfo1.panning;
+			pv->out1_volume  = lfo1[0] * *elem->lfo1.volume + 1.0f;
+		} else {
+			pv->out1_panning = 0.0f;
+			pv->out1_volume  = 1.0f;
 		}
-	#endif
-		if (elem->gen1.envtime0 != *elem->gen1.envtime) {
-			elem->gen1.envtime0  = *elem->gen1.envtime;
-			elem->updateEnvTimes(m_srate);
+	}
+
+	// filters
+
+	if (Slope >= 0) {
+		float *cut1 = vb->cut1;
+		float *res1 = vb->res1;
+		for (j = 0; j < nframes; ++j) {
+			const float env1 = 0.5f * (1.0f + vel1[j]
+				* *elem->dcf1.envelope * pv->dcf1_env.tick());
+			if (Lfo) {
+				cut1[j] = *elem->dcf1.cutoff
+					* env1 * (1.0f + *elem->lfo1.cutoff * lfo1[j]);
+				res1[j] = *elem->dcf1.reso
+					* env1 * (1.0f + *elem->lfo1.reso * lfo1[j]);
+			} else {
+				cut1[j] = *elem->dcf1.cutoff * env1;
+				res1[j] = *elem->dcf1.reso * env1;
+			}
 		}
-		if (*elem->lfo1.enabled > 0.0f) {
-			elem->lfo1_wave.reset_test(
-				drumkv1_wave::Shape(*elem->lfo1.shape), *elem->lfo1.width);
+		drumkv1_fast_sigmoid_1(cut1, nframes);
+		drumkv1_fast_sigmoid_1(res1, nframes);
+		switch (Slope) {
+		case 3: // Formant
+			for (j = 0; j < nframes; ++j)
+				gen1[j] = pv->dcf17.output(gen1[j], cut1[j], res1[j]);
+			if (Stereo) for (j = 0; j < nframes; ++j)
+				gen2[j] = pv->dcf18.output(gen2[j], cut1[j], res1[j]);
+			break;
+		case 2: // Biquad
+			for (j = 0; j < nframes; ++j)
+				gen1[j] = pv->dcf15.output(gen1[j], cut1[j], res1[j]);
+			if (Stereo) for (j = 0; j < nframes; ++j)
+				gen2[j] = pv->dcf16.output(gen2[j], cut1[j], res1[j]);
+			break;
+		case 1: // 24db/octave
+			for (j = 0; j < nframes; ++j)
+				gen1[j] = pv->dcf13.output(gen1[j], cut1[j], res1[j]);
+			if (Stereo) for (j = 0; j < nframes; ++j)
+				gen2[j] = pv->dcf14.output(gen2[j], cut1[j], res1[j]);
+			break;
+		case 0: // 12db/octave
+		default:
+			for (j = 0; j < nframes; ++j)
+				gen1[j] = pv->dcf11.output(gen1[j], cut1[j], res1[j]);
+			if (Stereo) for (j = 0; j < nframes; ++j)
+				gen2[j] = pv->dcf12.output(gen2[j], cut1[j], res1[j]);
+			break;
 		}
-		elem = elem->next();
 	}
 
-	// per voice
+	// volumes (envelope and panning gains)
 
-	drumkv1_voice *pv = m_play_list.next();
+	float *pan1 = vb->pan1;
+	float *pan2 = vb->pan2;
 
-	while (pv) {
+	const bool fade1_enabled = (pv->fade1_delta > 0.0f);
 
-		drumkv1_voice *pv_next = pv->next();
+	for (j = 0; j < nframes; ++j) {
+		const uint32_t n = n0 + j0 + j;
+		const uint32_t m = j0 + j;
+		const float vol1 = vel1[j] * elem->vol1.value(n)
+			* (Dca ? pv->dca1_env.tick() : 1.0f)
+			* (fade1_enabled ? pv->fade1_delta * float(pv->fade1_frames - m) : 1.0f)
+			* pv->out1_vol.value(m);
+		pan1[j] = vol1 * elem->pan1.value(n, 0) * pv->out1_pan.value(m, 0);
+		pan2[j] = vol1 * elem->pan1.value(n, 1) * pv->out1_pan.value(m, 1);
+	}
 
-		// controls
-		drumkv1_elem *elem = pv->elem;
+	// stereo width (mono samples have no side component)
 
-		const bool lfo1_enabled = (*elem->lfo1.enabled > 0.0f);
+	if (Stereo) {
+		float *wid1 = vb->wid1;
+		for (j = 0; j < nframes; ++j)
+			wid1[j] = elem->wid1.value(n0 + j0 + j);
+		drumkv1_simd_width(gen1, gen2, wid1, nframes);
+	} else {
+		::memcpy(gen2, gen1, nframes * sizeof(float));
+	}
 
-		const float lfo1_freq = (lfo1_enabled
-			? get_bpm(*elem->lfo1.bpm) / (60.01f - *elem->lfo1.rate * 60.0f) : 0.0f);
+	// outputs
 
-		const float modwheel1 = (lfo1_enabled
-			? m_ctl.modwheel + PITCH_SCALE * *elem->lfo1.pitch : 0.0f);
+	drumkv1_simd_mul(gen1, pan1, nframes);
+	drumkv1_simd_mul(gen2, pan2, nframes);
 
-		const bool dcf1_enabled = (*elem->dcf1.enabled > 0.0f);
-		const bool dca1_enabled = (*elem->dca1.enabled > 0.0f);
+	if (elem->silence1_level > 0.0f) {
+		pv->silence1_peak = drumkv1_simd_peak(gen1, nframes, pv->silence1_peak);
+		pv->silence1_peak = drumkv1_simd_peak(gen2, nframes, pv->silence1_peak);
+	}
 
-		const float fxsend1	= *elem->out1.fxsend * *elem->out1.fxsend;
+	for (uint16_t k = 0; k < m_nchannels; ++k) {
+		drumkv1_simd_mix(v_outs[k] + j0, v_sfxs[k] + j0,
+			(k & 1 ? gen2 : gen1), fxsend1, nframes);
+	}
+}
 
-		// channel indexes
 
-		const uint16_t k1 = 0;
-		const uint16_t k2 = (elem->gen1_sample.channels() > 1 ? 1 : 0);
+// specialized voice render kernel table:
+// index = (((slope + 1) * 2 + lfo) * 2 + dca) * 2 + stereo.
+#define DRUMKV1_RENDER_FUNCS(slope) \
+	&drumkv1_impl::render_voice<slope, false, false, false>, \
+	&drumkv1_impl::render_voice<slope, false, false, true>,  \
+	&drumkv1_impl::render_voice<slope, false, true,  false>, \
+	&drumkv1_impl::render_voice<slope, false, true,  true>,  \
+	&drumkv1_impl::render_voice<slope, true,  false, false>, \
+	&drumkv1_impl::render_voice<slope, true,  false, true>,  \
+	&drumkv1_impl::render_voice<slope, true,  true,  false>, \
+	&drumkv1_impl::render_voice<slope, true,  true,  true>
+
+const drumkv1_impl::RenderFunc drumkv1_impl::g_render_funcs[] = {
+	DRUMKV1_RENDER_FUNCS(-1),	// filter off
+	DRUMKV1_RENDER_FUNCS(0),	// 12db/octave
+	DRUMKV1_RENDER_FUNCS(1),	// 24db/octave
+	DRUMKV1_RENDER_FUNCS(2),	// Biquad
+	DRUMKV1_RENDER_FUNCS(3)		// Formant
+};
 
-		// output buffers
+#undef DRUMKV1_RENDER_FUNCS
 
-		for (k = 0; k < m_nchannels; ++k) {
-			v_outs[k] = outs[k];
-			v_sfxs[k] = m_sfxs[k];
-		}
 
-		uint32_t nblock = nframes;
+// select the specialized voice render kernel (index).
+int drumkv1_impl::render_kernel ( drumkv1_elem *elem )
+{
+	int slope = -1;
+	if (*elem->dcf1.enabled > 0.0f) {
+		slope = int(*elem->dcf1.slope);
+		if (slope < 0 || slope > 3)
+			slope = 0; // 12db/octave
+	}
 
-		while (nblock > 0) {
+	const int lfo = (*elem->lfo1.enabled > 0.0f ? 1 : 0);
+	const int dca = (*elem->dca1.enabled > 0.0f ? 1 : 0);
+	const int stereo = (elem->gen1_sample.channels() > 1 ? 1 : 0);
 
-			uint32_t ngen = nblock;
+	return (((slope + 1) * 2 + lfo) * 2 + dca) * 2 + stereo;
+}
 
-			// process envelope stages
+#endif	// CONFIG_VOICE_BLOCK
 
-			if (pv->dca1_env.running && pv->dca1_env.frames < ngen)
-				ngen = pv->dca1_env.frames;
-			if (pv->dcf1_env.running && pv->dcf1_env.frames < ngen)
-				ngen = pv->dcf1_env.frames;
-			if (pv->lfo1_env.running && pv->lfo1_env.frames < ngen)
-				ngen = pv->lfo1_env.frames;
 
-			for (uint32_t j = 0; j < ngen; ++j) {
+// render one playing voice (returns true when over);
+// noffset is the sub-block offset into the element (block) ramps.
+bool drumkv1_impl::process_voice ( drumkv1_voice *pv, float **outs, float **sfxs,
+	uint32_t noffset, uint32_t nframes, voice_block *vb )
+{
+	// controls
+	drumkv1_elem *elem = pv->elem;
 
-				// velocities
+	const bool dca1_enabled = (*elem->dca1.enabled > 0.0f);
+	const bool fade1_enabled = (pv->fade1_delta > 0.0f);
 
-				const float vel1
-					= (pv->vel + (1.0f - pv->vel) * pv->dca1_pre.value(j));
+	const bool silence1_enabled
+		= (elem->silence1_level > 0.0f && m_silence_frames > 0);
 
-				// generators
+#ifdef CONFIG_VOICE_BLOCK
 
-				const float lfo1_env
-					= (lfo1_enabled ? pv->lfo1_env.tick() : 0.0f);
-				const float lfo1
-					= (lfo1_enabled ? pv->lfo1_sample * lfo1_env : 0.0f);
+	// re-bind render kernel (follow live control changes)
+	pv->render1 = render_kernel(elem);
 
-				pv->gen1.next(pv->gen1_freq
-					* (m_ctl.pitchbend + modwheel1 * lfo1));
+#endif
 
-				float gen1 = pv->gen1.value(k1);
-				float gen2 = pv->gen1.value(k2);
+#ifndef CONFIG_VOICE_BLOCK
 
-				if (lfo1_enabled) {
-					pv->lfo1_sample = pv->lfo1.sample(lfo1_freq
-						* (1.0f + SWEEP_SCALE * *elem->lfo1.sweep * lfo1_env));
-				}
+	const bool lfo1_enabled = (*elem->lfo1.enabled > 0.0f);
 
-				// filters
+	const float lfo1_freq = (lfo1_enabled
+		? get_bpm(*elem->lfo1.bpm) / (60.01f - *elem->lfo1.rate * 60.0f) : 0.0f);
 
-				if (dcf1_enabled) {
-					const float env1 = 0.5f * (1.0f + vel1
-						* *elem->dcf1.envelope * pv->dcf1_env.tick());
-					const float cutoff1 = drumkv1_sigmoid_1(*elem->dcf1.cutoff
-						* env1 * (1.0f + *elem->lfo1.cutoff * lfo1));
-					const float reso1 = drumkv1_sigmoid_1(*elem->dcf1.reso
-						* env1 * (1.0f + *elem->lfo1.reso * lfo1));
-					switch (int(*elem->dcf1.slope)) {
-					case 3: // Formant
-						gen1 = pv->dcf17.output(gen1, cutoff1, reso1);
-						gen2 = pv->dcf18.output(gen2, cutoff1, reso1);
-						break;
-					case 2: // Biquad
-						gen1 = pv->dcf15.output(gen1, cutoff1, reso1);
-						gen2 = pv->dcf16.output(gen2, cutoff1, reso1);
-						break;
-					case 1: // 24db/octave
-						gen1 = pv->dcf13.output(gen1, cutoff1, reso1);
-						gen2 = pv->dcf14.output(gen2, cutoff1, reso1);
-						break;
-					case 0: // 12db/octave
-					default:
-						gen1 = pv->dcf11.output(gen1, cutoff1, reso1);
-						gen2 = pv->dcf12.output(gen2, cutoff1, reso1);
-						break;
-					}
-				}
+	const float modwheel1 = (lfo1_enabled
+		? m_ctl.modwheel + PITCH_SCALE * *elem->lfo1.pitch : 0.0f);
 
-				// volumes
-
-				const float wid1 = elem->wid1.value(j);
-				const float mid1 = 0.5f * (gen1 + gen2);
-				const float sid1 = 0.5f * (gen1 - gen2);
-				const float vol1 = vel1 * elem->vol1.value(j)
-					* (dca1_enabled ? pv->dca1_env.tick() : 1.0f)
-					* pv->out1_vol.value(j);
-
-				// outputs
-
-				const float out1 = vol1 * (mid1 + sid1 * wid1)
-					* elem->pan1.value(j, 0)
-					* pv->out1_pan.value(j, 0);
-				const float out2 = vol1 * (mid1 - sid1 * wid1)
-					* elem->pan1.value(j, 1)
-					* pv->out1_pan.value(j, 1);
-
-				for (k = 0; k < m_nchannels; ++k) {
-					const float dry = (k & 1 ? out2 : out1);
-					const float wet = fxsend1 * dry;
-					*v_outs[k]++ += dry - wet;
-					*v_sfxs[k]++ += wet;
-				}
+	const bool dcf1_enabled = (*elem->dcf1.enabled > 0.0f);
+
+	const float fxsend1	= *elem->out1.fxsend * *elem->out1.fxsend;
+
+	// channel indexes
+
+	const uint16_t k1 = 0;
+	const uint16_t k2 = (elem->gen1_sample.channels() > 1 ? 1 : 0);
+
+#endif
+
+	// output buffers
+
+	float *v_outs[m_nchannels];
+	float *v_sfxs[m_nchannels];
+
+	uint16_t k;
+
+	for (k = 0; k < m_nchannels; ++k) {
+		v_outs[k] = outs[k];
+		v_sfxs[k] = sfxs[k];
+	}
+
+	uint32_t nblock = nframes;
+
+	while (nblock > 0) {
+
+		uint32_t ngen = nblock;
+
+		// process envelope stages
+
+		if (pv->dca1_env.running && pv->dca1_env.frames < ngen)
+			ngen = pv->dca1_env.frames;
+		if (pv->dcf1_env.running && pv->dcf1_env.frames < ngen)
+			ngen = pv->dcf1_env.frames;
+		if (pv->lfo1_env.running && pv->lfo1_env.frames < ngen)
+			ngen = pv->lfo1_env.frames;
+		if (fade1_enabled && pv->fade1_frames < ngen)
+			ngen = pv->fade1_frames;
+
+	#ifdef CONFIG_VOICE_BLOCK
+
+		// staged block render
+
+		const RenderFunc render_func = g_render_funcs[pv->render1];
+
+		for (uint32_t j = 0; j < ngen; j += MAX_VOICE_BLOCK) {
+			uint32_t nvblock = ngen - j;
+			if (nvblock > MAX_VOICE_BLOCK)
+				nvblock = MAX_VOICE_BLOCK;
+			(this->*render_func)(pv, v_outs, v_sfxs, noffset, j, nvblock, vb);
+		}
+
+		for (k = 0; k < m_nchannels; ++k) {
+			v_outs[k] += ngen;
+			v_sfxs[k] += ngen;
+		}
+
+	#else
+
+		// reference (per-sample) render
+
+		for (uint32_t j = 0; j < ngen; ++j) {
+
+			// velocities
 
-				if (j == 0) {
-					pv->out1_panning = lfo1 * *elem->lfo1.panning;
-					pv->out1_volume  = lfo1 * *elem->lfo1.volume + 1.0f;
+			const float vel1
+				= (pv->vel + (1.0f - pv->vel) * pv->dca1_pre.value(j));
+
+			// generators
+
+			const float lfo1_env
+				= (lfo1_enabled ? pv->lfo1_env.tick() : 0.0f);
+			const float lfo1
+				= (lfo1_enabled ? pv->lfo1_sample * lfo1_env : 0.0f);
+
+			pv->gen1.next(pv->gen1_freq
+				* (m_ctl.pitchbend + modwheel1 * lfo1));
+
+			float gen1 = pv->gen1.value(k1);
+			float gen2 = pv->gen1.value(k2);
+
+			if (lfo1_enabled) {
+				pv->lfo1_sample = pv->lfo1.sample(lfo1_freq
+					* (1.0f + SWEEP_SCALE * *elem->lfo1.sweep * lfo1_env));
+			}
+
+			// filters
+
+			if (dcf1_enabled) {
+				const float env1 = 0.5f * (1.0f + vel1
+					* *elem->dcf1.envelope * pv->dcf1_env.tick());
+				const float cutoff1 = drumkv1_sigmoid_1(*elem->dcf1.cutoff
+					* env1 * (1.0f + *elem->lfo1.cutoff * lfo1));
+				const float reso1 = drumkv1_sigmoid_1(*elem->dcf1.reso
+					* env1 * (1.0f + *elem->lfo1.reso * lfo1));
+				switch (int(*elem->dcf1.slope)) {
+				case 3: // Formant
+					gen1 = pv->dcf17.output(gen1, cutoff1, reso1);
+					gen2 = pv->dcf18.output(gen2, cutoff1, reso1);
+					break;
+				case 2: // Biquad
+					gen1 = pv->dcf15.output(gen1, cutoff1, reso1);
+					gen2 = pv->dcf16.output(gen2, cutoff1, reso1);
+					break;
+				case 1: // 24db/octave
+					gen1 = pv->dcf13.output(gen1, cutoff1, reso1);
+					gen2 = pv->dcf14.output(gen2, cutoff1, reso1);
+					break;
+				case 0: // 12db/octave
+				default:
+					gen1 = pv->dcf11.output(gen1, cutoff1, reso1);
+					gen2 = pv->dcf12.output(gen2, cutoff1, reso1);
+					break;
 				}
 			}
 
-			nblock -= ngen;
+			// volumes
+
+			const float wid1 = elem->wid1.value(noffset + j);
+			const float mid1 = 0.5f * (gen1 + gen2);
+			const float sid1 = 0.5f * (gen1 - gen2);
+			const float vol1 = vel1 * elem->vol1.value(noffset + j)
+				* (dca1_enabled ? pv->dca1_env.tick() : 1.0f)
+				* (fade1_enabled ? pv->fade1_delta * float(pv->fade1_frames - j) : 1.0f)
+				* pv->out1_vol.value(j);
+
+			// outputs
+
+			const float out1 = vol1 * (mid1 + sid1 * wid1)
+				* elem->pan1.value(noffset + j, 0)
+				* pv->out1_pan.value(j, 0);
+			const float out2 = vol1 * (mid1 - sid1 * wid1)
+				* elem->pan1.value(noffset + j, 1)
+				* pv->out1_pan.value(j, 1);
+
+			for (k = 0; k < m_nchannels; ++k) {
+				const float dry = (k & 1 ? out2 : out1);
+				const float wet = fxsend1 * dry;
+				*v_outs[k]++ += dry - wet;
+				*v_sfxs[k]++ += wet;
+			}
 
-			// voice ramps countdown
+			if (silence1_enabled) {
+				pv->silence1_peak = drumkv1_max(pv->silence1_peak,
+					drumkv1_max(::fabsf(out1), ::fabsf(out2)));
+			}
 
-			pv->dca1_pre.process(ngen);
-			pv->out1_pan.process(ngen);
-			pv->out1_vol.process(ngen);
+			if (j == 0) {
+				pv->out1_panning = lfo1 * *elem->lfo1.panning;
+				pv->out1_volume  = lfo1 * *elem->lfo1.volume + 1.0f;
+			}
+		}
 
-			// envelope countdowns
+	#endif
 
-			if (pv->dca1_env.running && pv->dca1_env.frames == 0)
-				elem->dca1.env.next(&pv->dca1_env);
+		nblock -= ngen;
+		noffset += ngen;
 
-			if (pv->gen1.isOver() ||
-				(dca1_enabled && pv->dca1_env.stage == drumkv1_env::Idle)) {
-				if (pv->note >= 0)
-					m_notes[pv->note] = nullptr;
-				if (pv->group >= 0 && m_group[pv->group] == pv)
-					m_group[pv->group] = nullptr;
-				free_voice(pv);
-				nblock = 0;
-			} else {
-				if (pv->dcf1_env.running && pv->dcf1_env.frames == 0)
-					elem->dcf1.env.next(&pv->dcf1_env);
-				if (pv->lfo1_env.running && pv->lfo1_env.frames == 0)
-					elem->lfo1.env.next(&pv->lfo1_env);
+		// voice ramps countdown
+
+		pv->dca1_pre.process(ngen);
+		pv->out1_pan.process(ngen);
+		pv->out1_vol.process(ngen);
+
+		// envelope countdowns
+
+		if (pv->dca1_env.running && pv->dca1_env.frames == 0)
+			elem->dca1.env.next(&pv->dca1_env);
+
+		if (pv->gen1.isOver() ||
+			(dca1_enabled && pv->dca1_env.stage == drumkv1_env::Idle))
+			return true;
+
+		// silent voice retirement (once audible)
+
+		if (silence1_enabled) {
+			if (pv->silence1_peak >= elem->silence1_level) {
+				pv->silence1_armed = true;
+				pv->silence1_frames = 0;
+			}
+			else
+			if (pv->silence1_armed) {
+				pv->silence1_frames += ngen;
+				if (pv->silence1_frames >= m_silence_frames)
+					return true;
 			}
+			pv->silence1_peak = 0.0f;
 		}
 
-		// next playing voice
+		// voice-stealing fade-out countdown
+
+		if (fade1_enabled) {
+			pv->fade1_frames -= ngen;
+			if (pv->fade1_frames == 0)
+				return true;
+		}
 
-		pv = pv_next;
+		if (pv->dcf1_env.running && pv->dcf1_env.frames == 0)
+			elem->dcf1.env.next(&pv->dcf1_env);
+		if (pv->lfo1_env.running && pv->lfo1_env.frames == 0)
+			elem->lfo1.env.next(&pv->lfo1_env);
 	}
 
-	// chorus
-	if (m_nchannels > 1) {
-		m_chorus.process(m_sfxs[0], m_sfxs[1], nframes, *m_cho.wet,
-			*m_cho.delay, *m_cho.feedb, *m_cho.rate, *m_cho.mod);
+	return false;
+}
+
+
+// render playing voices (per worker slot)
+void drumkv1_impl::render_work ( uint16_t islot )
+{
+	render_slot& slot = m_slots[islot];
+
+	DRUMKV1_RTCHECK_SCOPE("drumkv1_impl::render_work");
+
+	float **outs = m_render_outs;
+	float **sfxs = m_render_sfxs;
+
+	if (islot > 0) {
+		outs = slot.outs;
+		sfxs = slot.sfxs;
 	}
 
-	// effects
+	const uint32_t noffset = m_render_noffset;
+	const uint32_t nframes = m_render_nframes;
+
+	uint32_t i = m_render_index++;
+	while (i < m_render_nvoices) {
+		if (islot > 0 && !slot.active) {
+			for (uint16_t k = 0; k < m_nchannels; ++k) {
+				::memset(outs[k], 0, nframes * sizeof(float));
+				::memset(sfxs[k], 0, nframes * sizeof(float));
+			}
+			slot.active = true;
+		}
+		m_render_over[i] = process_voice(m_render_voices[i],
+			outs, sfxs, noffset, nframes, &slot.vblock);
+		i = m_render_index++;
+	}
+}
+
+
+// worker pool trampoline.
+static void drumkv1_impl_render ( void *arg, uint16_t islot )
+{
+	static_cast<drumkv1_impl *> (arg)->render_work(islot);
+}
+
+
+// render all playing voices (sub-block)
+void drumkv1_impl::render_voices (
+	float **outs, uint32_t noffset, uint32_t nframes )
+{
+	drumkv1_voice *pv = m_play_list.next();
+
+	uint32_t nvoices = 0;
+	while (pv && nvoices < m_nvoices_pool) {
+		m_render_voices[nvoices] = pv;
+		m_render_over[nvoices] = false;
+		++nvoices;
+		pv = pv->next();
+	}
+
+	float *v_outs[m_nchannels];
+	float *v_sfxs[m_nchannels];
+
+	uint16_t k;
+
 	for (k = 0; k < m_nchannels; ++k) {
-		float *in = m_sfxs[k];
-		// flanger
-		m_flanger[k].process(in, nframes, *m_fla.wet,
-			*m_fla.delay, *m_fla.feedb, *m_fla.daft * float(k));
-		// phaser
-		m_phaser[k].process(in, nframes, *m_pha.wet,
-			*m_pha.rate, *m_pha.feedb, *m_pha.depth, *m_pha.daft * float(k));
-		// delay
-		m_delay[k].process(in, nframes, *m_del.wet,
-			*m_del.delay, *m_del.feedb, get_bpm(*m_del.bpm));
+		v_outs[k] = outs[k] + noffset;
+		v_sfxs[k] = m_sfxs[k] + noffset;
 	}
 
-	// reverb
-	if (m_nchannels > 1) {
-		m_reverb.process(m_sfxs[0], m_sfxs[1], nframes, *m_rev.wet,
-			*m_rev.feedb, *m_rev.room, *m_rev.damp, *m_rev.width);
+	m_render_nvoices = nvoices;
+	m_render_noffset = noffset;
+	m_render_nframes = nframes;
+	m_render_outs = v_outs;
+	m_render_sfxs = v_sfxs;
+	m_render_index = 0;
+
+	if (nvoices > 1)
+		m_worker->run(drumkv1_impl_render, this);
+	else
+	if (nvoices > 0)
+		render_work(0);
+
+	// mix-down worker accumulators
+	for (uint16_t i = 1; i < m_worker->slots(); ++i) {
+		render_slot& slot = m_slots[i];
+		if (!slot.active)
+			continue;
+		for (k = 0; k < m_nchannels; ++k) {
+			drumkv1_simd_add(v_outs[k], slot.outs[k], nframes);
+			drumkv1_simd_add(v_sfxs[k], slot.sfxs[k], nframes);
+		}
+		slot.active = false;
+	}
+
+	// free voices over
+	for (uint32_t i = 0; i < nvoices; ++i) {
+		if (!m_render_over[i])
+			continue;
+		pv = m_render_voices[i];
+		if (pv->note >= 0)
+			m_notes[pv->note] = nullptr;
+		if (pv->group >= 0 && m_group[pv->group] == pv)
+			m_group[pv->group] = nullptr;
+		free_voice(pv);
 	}
+}
+
+
+void drumkv1_impl::process ( float **ins, float **outs, uint32_t nframes,
+	const drumkv1::MidiEvent *events, uint32_t nevents )
+{
+	if (!m_running) return;
+
+	// pipelined effects latency is one nominal block:
+	// blocks may never be longer than that...
+	const uint32_t nsize = (m_fx_worker ? m_fx_nsize : m_nsize);
+
+	if (nframes <= nsize) {
+		process_block(ins, outs, nframes, events, nevents, 0);
+		return;
+	}
+
+	// never reallocate here: split in preallocated buffer size blocks...
+	if (nsize < 1) return;
+
+	float *ins2[m_nchannels];
+	float *outs2[m_nchannels];
+
+	uint32_t i = 0;
+	for (uint32_t noffset = 0; noffset < nframes; noffset += nsize) {
+		uint32_t nblock = nframes - noffset;
+		if (nblock > nsize)
+			nblock = nsize;
+		uint32_t j = nevents;
+		if (noffset + nblock < nframes) {
+			j = i;
+			while (j < nevents && events[j].time < noffset + nblock)
+				++j;
+		}
+		for (uint16_t k = 0; k < m_nchannels; ++k) {
+			ins2[k]  = ins[k]  + noffset;
+			outs2[k] = outs[k] + noffset;
+		}
+		process_block(ins2, outs2, nblock, events + i, j - i, noffset);
+		i = j;
+	}
+}
+
+
+void drumkv1_impl::process_block ( float **ins, float **outs, uint32_t nframes,
+	const drumkv1::MidiEvent *events, uint32_t nevents, uint32_t noffset )
+{
+	uint16_t k;
 
-	// output mix-down
 	for (k = 0; k < m_nchannels; ++k) {
-		uint32_t n;
-		float *sfx = m_sfxs[k];
-		// compressor
-		if (int(*m_dyn.compress) > 0)
-			m_comp[k].process(sfx, nframes);
-		// limiter
-		if (int(*m_dyn.limiter) > 0) {
-			float *p = sfx;
-			float *q = sfx;
-			for (n = 0; n < nframes; ++n)
-				*q++ = drumkv1_sigmoid(*p++);
+		::memset(m_sfxs[k], 0, nframes * sizeof(float));
+		::memcpy(outs[k], ins[k], nframes * sizeof(float));
+	}
+
+	// process direct note on/off...
+	while (m_direct_note > 0) {
+		const direct_note& data
+			= m_direct_notes[--m_direct_note];
+		process_midi((uint8_t *) &data, sizeof(data));
+	}
+
+	drumkv1_elem *elem = m_elem_list.next();
+	while (elem) {
+	#if 0
+		if (elem->gen1.sample0 != *elem->gen1.sample) {
+			elem->gen1.sample0  = *elem->gen1.sample;
+			elem->gen1_sample.reset(note_freq(elem->gen1.sample0));
+		}
+	#endif
+		if (elem->gen1.envtime0 != *elem->gen1.envtime) {
+			elem->gen1.envtime0  = *elem->gen1.envtime;
+			elem->updateEnvTimes(m_srate);
+		}
+		if (*elem->lfo1.enabled > 0.0f) {
+			elem->lfo1_wave.reset_test(
+				drumkv1_wave::Shape(*elem->lfo1.shape), *elem->lfo1.width);
+		}
+		elem = elem->next();
+	}
+
+	// per voice (sample-accurate, split on each event)
+
+	uint32_t ndelta = 0;
+
+	for (uint32_t i = 0; i < nevents; ++i) {
+		const drumkv1::MidiEvent& event = events[i];
+		uint32_t ntime = (event.time > noffset ? event.time - noffset : 0);
+		if (ntime > nframes)
+			ntime = nframes;
+		if (ntime > ndelta) {
+			render_voices(outs, ndelta, ntime - ndelta);
+			ndelta = ntime;
 		}
+		process_midi(event.data, event.size);
+	}
+
+	if (nframes > ndelta)
+		render_voices(outs, ndelta, nframes - ndelta);
+
+	// limiter switch (read once per block, for both paths)
+	const bool limiter = (int(*m_dyn.limiter) > 0);
+
+	// dry path (limiter lookahead) latency compensation
+	process_dry(outs, nframes, limiter);
+
+	// effects (pipelined, one block late; or in-line)
+	if (m_fx_worker) {
+		process_fx_pipe(outs, nframes, limiter);
+	} else {
+		process_fx(m_sfxs, nframes, limiter);
 		// mix-down
-		float *out = outs[k];
-		for (n = 0; n < nframes; ++n)
-			*out++ += *sfx++;
+		for (k = 0; k < m_nchannels; ++k)
+			drumkv1_simd_add(outs[k], m_sfxs[k], nframes);
 	}
 
 	// post-processing
@@ -2465,6 +3411,177 @@ void drumkv1_impl::process ( float **ins, float **outs, uint32_t nframes )
 }
 
 
+// effects processing (fx sends, in-place)
+void drumkv1_impl::process_fx ( float **sfxs, uint32_t nframes, bool limiter )
+{
+	DRUMKV1_RTCHECK_SCOPE("drumkv1_impl::process_fx");
+
+	// denormals flush-to-zero (whole block)
+	drumkv1_simd_ftz ftz;
+
+	uint16_t k;
+
+	// effects input (voice mix-down) peak levels;
+	// effects are bypassed while silent and tails decayed...
+	float peaks[m_nchannels];
+	for (k = 0; k < m_nchannels; ++k)
+		peaks[k] = drumkv1_simd_peak(sfxs[k], nframes, 0.0f);
+
+	// chorus
+	if (m_nchannels > 1) {
+		const float peak = (peaks[0] > peaks[1] ? peaks[0] : peaks[1]);
+		if (m_chorus.active(peak, nframes, *m_cho.delay, *m_cho.feedb)) {
+			m_chorus.process(sfxs[0], sfxs[1], nframes, *m_cho.wet,
+				*m_cho.delay, *m_cho.feedb, *m_cho.rate, *m_cho.mod);
+			peaks[0] = drumkv1_simd_peak(sfxs[0], nframes, 0.0f);
+			peaks[1] = drumkv1_simd_peak(sfxs[1], nframes, 0.0f);
+		}
+	}
+
+	// effects
+	for (k = 0; k < m_nchannels; ++k) {
+		float *in = sfxs[k];
+		// flanger
+		if (m_flanger[k].active(peaks[k], nframes, *m_fla.delay, *m_fla.feedb)) {
+			m_flanger[k].process(in, nframes, *m_fla.wet,
+				*m_fla.delay, *m_fla.feedb, *m_fla.daft * float(k));
+			peaks[k] = drumkv1_simd_peak(in, nframes, 0.0f);
+		}
+		// phaser
+		if (m_phaser[k].active(peaks[k], nframes, *m_pha.feedb)) {
+			m_phaser[k].process(in, nframes, *m_pha.wet,
+				*m_pha.rate, *m_pha.feedb, *m_pha.depth, *m_pha.daft * float(k));
+			peaks[k] = drumkv1_simd_peak(in, nframes, 0.0f);
+		}
+		// delay
+		const float bpm = get_bpm(*m_del.bpm);
+		if (m_delay[k].active(peaks[k], nframes, *m_del.delay, *m_del.feedb, bpm)) {
+			m_delay[k].process(in, nframes, *m_del.wet,
+				*m_del.delay, *m_del.feedb, bpm);
+			peaks[k] = drumkv1_simd_peak(in, nframes, 0.0f);
+		}
+	}
+
+	// reverb
+	if (m_nchannels > 1) {
+		const float peak = (peaks[0] > peaks[1] ? peaks[0] : peaks[1]);
+		if (m_reverb.active(peak, nframes, *m_rev.room)) {
+			m_reverb.process(sfxs[0], sfxs[1], nframes, *m_rev.wet,
+				*m_rev.feedb, *m_rev.room, *m_rev.damp, *m_rev.width);
+		}
+	}
+
+	// dynamics (stereo-linked)
+	if (int(*m_dyn.compress) > 0)
+		m_comp.process(sfxs, m_nchannels, nframes);
+
+	// limiter (lookahead delayed, if enabled)
+	m_limiter.process(sfxs, m_nchannels, nframes, limiter);
+}
+
+
+// effects thread trampoline.
+static void drumkv1_impl_fx ( void *arg, uint16_t /*islot*/ )
+{
+	static_cast<drumkv1_impl *> (arg)->fx_work();
+}
+
+
+// effects thread work (previous block fx sends).
+void drumkv1_impl::fx_work (void)
+{
+	process_fx(m_fx_sfxs, m_fx_nframes, m_fx_limiter);
+}
+
+
+// pipelined effects: hand over current block fx sends to the effects
+// thread, while mixing down the previous block effects output, through
+// a fixed latency ring (one nominal block size).
+void drumkv1_impl::process_fx_pipe (
+	float **outs, uint32_t nframes, bool limiter )
+{
+	// join previous block effects...
+	m_fx_worker->wait();
+
+	uint16_t k;
+
+	// previous block effects output (into latency ring)...
+	if (m_fx_nframes > 0) {
+		uint32_t n1 = m_fx_nsize - m_fx_ring_w;
+		if (n1 > m_fx_nframes)
+			n1 = m_fx_nframes;
+		const uint32_t n2 = m_fx_nframes - n1;
+		for (k = 0; k < m_nchannels; ++k) {
+			float *ring = m_fx_ring[k];
+			const float *sfx = m_fx_sfxs[k];
+			::memcpy(ring + m_fx_ring_w, sfx, n1 * sizeof(float));
+			::memcpy(ring, sfx + n1, n2 * sizeof(float));
+		}
+		m_fx_ring_w += m_fx_nframes;
+		if (m_fx_ring_w >= m_fx_nsize)
+			m_fx_ring_w -= m_fx_nsize;
+	}
+
+	// mix-down (from latency ring)...
+	uint32_t n1 = m_fx_nsize - m_fx_ring_r;
+	if (n1 > nframes)
+		n1 = nframes;
+	const uint32_t n2 = nframes - n1;
+	for (k = 0; k < m_nchannels; ++k) {
+		const float *ring = m_fx_ring[k];
+		drumkv1_simd_add(outs[k], ring + m_fx_ring_r, n1);
+		drumkv1_simd_add(outs[k] + n1, ring, n2);
+	}
+	m_fx_ring_r += nframes;
+	if (m_fx_ring_r >= m_fx_nsize)
+		m_fx_ring_r -= m_fx_nsize;
+
+	// swap and hand over current block fx sends...
+	float **sfxs = m_fx_sfxs;
+	m_fx_sfxs = m_sfxs;
+	m_sfxs = sfxs;
+	m_fx_nframes = nframes;
+	m_fx_limiter = limiter;
+
+	m_fx_worker->start(drumkv1_impl_fx, this);
+}
+
+
+// dry path (voice mix-down) delayed to match the limiter lookahead,
+// if enabled; the pipelined effects latency is on the wet path only.
+void drumkv1_impl::process_dry (
+	float **outs, uint32_t nframes, bool limiter )
+{
+	const uint32_t ndelay = (limiter ? m_limiter.latency() : 0);
+
+	// flush stale contents on any delay change...
+	if (m_dry_delay != ndelay) {
+		m_dry_delay = ndelay;
+		for (uint16_t k = 0; k < m_nchannels; ++k)
+			::memset(m_dry_ring[k], 0, ndelay * sizeof(float));
+		m_dry_ring_w = 0;
+	}
+
+	if (ndelay < 1)
+		return;
+
+	uint32_t w = m_dry_ring_w;
+	for (uint16_t k = 0; k < m_nchannels; ++k) {
+		float *ring = m_dry_ring[k];
+		float *out = outs[k];
+		w = m_dry_ring_w;
+		for (uint32_t n = 0; n < nframes; ++n) {
+			const float x = out[n];
+			out[n] = ring[w];
+			ring[w] = x;
+			if (++w >= ndelay)
+				w = 0;
+		}
+	}
+	m_dry_ring_w = w;
+}
+
+
 void drumkv1_impl::sampleReverseTest (void)
 {
 	if (m_running && m_elem) m_elem->element.sampleReverseTest();
@@ -2562,6 +3679,24 @@ uint32_t drumkv1::bufferSize (void) const
 }
 
 
+void drumkv1::setNominalBufferSize ( uint32_t nsize )
+{
+	m_pImpl->setNominalBufferSize(nsize);
+}
+
+
+uint32_t drumkv1::nominalBufferSize (void) const
+{
+	return m_pImpl->nominalBufferSize();
+}
+
+
+uint32_t drumkv1::latency (void) const
+{
+	return m_pImpl->latency();
+}
+
+
 drumkv1_element *drumkv1::addElement ( int key )
 {
 	return m_pImpl->addElement(key);
@@ -2695,6 +3830,30 @@ float drumkv1::tempo (void) const
 }
 
 
+void drumkv1::setPolyphony ( int nvoices )
+{
+	m_pImpl->setPolyphony(nvoices);
+}
+
+
+uint16_t drumkv1::polyphony (void) const
+{
+	return m_pImpl->polyphony();
+}
+
+
+void drumkv1::setVoiceSteal ( VoiceSteal steal )
+{
+	m_pImpl->setVoiceSteal(steal);
+}
+
+
+drumkv1::VoiceSteal drumkv1::voiceSteal (void) const
+{
+	return m_pImpl->voiceSteal();
+}
+
+
 void drumkv1::setParamPort ( ParamIndex index, float *pfParam )
 {
 	m_pImpl->setParamPort(index, pfParam);
@@ -2726,17 +3885,31 @@ void drumkv1::process_midi ( uint8_t *data, uint32_t size )
 	fprintf(stderr, "\n");
 #endif
 
+	DRUMKV1_RTCHECK_SCOPE("drumkv1::process_midi");
+
 	m_pImpl->process_midi(data, size);
 }
 
 
 void drumkv1::process ( float **ins, float **outs, uint32_t nframes )
 {
+	DRUMKV1_RTCHECK_SCOPE("drumkv1::process");
+
 	m_pImpl->process(ins, outs, nframes);
 
 	m_pImpl->sampleReverseTest();
 }
 
+void drumkv1::process ( float **ins, float **outs, uint32_t nframes,
+	const MidiEvent *events, uint32_t nevents )
+{
+	DRUMKV1_RTCHECK_SCOPE("drumkv1::process");
+
+	m_pImpl->process(ins, outs, nframes, events, nevents);
+
+	m_pImpl->sampleReverseTest();
+}
+
 
 // reset/swap all element params A/B
 
@@ -2805,11 +3978,11 @@ int drumkv1_element::note (void) const
 void drumkv1_element::setSampleFile ( const char *pszSampleFile )
 {
 	if (m_pElem) {
-		m_pElem->gen1_sample.close();
 		if (pszSampleFile) {
 			m_pElem->gen1_sample.open(pszSampleFile,
 				drumkv1_freq(m_pElem->gen1.sample0));
 		}
+		else m_pElem->gen1_sample.close();
 	}
 }
 
@@ -2865,6 +4038,17 @@ uint32_t drumkv1_element::offsetEnd (void) const
 }
 
 
+void drumkv1_element::setSilenceThreshold ( float fThreshold )
+{
+	if (m_pElem) m_pElem->setSilenceThreshold(fThreshold);
+}
+
+float drumkv1_element::silenceThreshold (void) const
+{
+	return (m_pElem ? m_pElem->silence1_db : DEF_SILENCE_DB);
+}
+
+
 void drumkv1_element::setParamPort ( drumkv1::ParamIndex index, float *pfParam )
 {
 	drumkv1_port *pParamPort = paramPort(index);
@@ -57,6 +57,11 @@ public:
 	void setBufferSize(uint32_t nsize);
 	uint32_t bufferSize() const;
 
+	void setNominalBufferSize(uint32_t nsize);
+	uint32_t nominalBufferSize() const;
+
+	uint32_t latency() const;
+
 	drumkv1_element *addElement(int key);
 	drumkv1_element *element(int key) const;
 	void removeElement(int key);
@@ -87,6 +92,19 @@ public:
 	void setTempo(float bpm);
 	float tempo() const;
 
+	void setPolyphony(int nvoices);
+	uint16_t polyphony() const;
+
+	enum VoiceSteal {
+
+		StealOldest = 0,
+		StealQuietest,
+		StealElement
+	};
+
+	void setVoiceSteal(VoiceSteal steal);
+	VoiceSteal voiceSteal() const;
+
 	enum ParamIndex	 {
 
 		GEN1_SAMPLE = 0,
@@ -191,6 +209,17 @@ public:
 	void process_midi(uint8_t *data, uint32_t size);
 	void process(float **ins, float **outs, uint32_t nframes);
 
+	// timestamped MIDI event (frame offset within block)
+	struct MidiEvent
+	{
+		uint32_t time;
+		uint8_t *data;
+		uint32_t size;
+	};
+
+	void process(float **ins, float **outs, uint32_t nframes,
+		const MidiEvent *events, uint32_t nevents);
+
 	virtual void updatePreset(bool bDirty) = 0;
 	virtual void updateParam(ParamIndex index) = 0;
 	virtual void updateParams() = 0;
@@ -258,6 +287,9 @@ public:
 	uint32_t offsetStart() const;
 	uint32_t offsetEnd() const;
 
+	void setSilenceThreshold(float fThreshold);
+	float silenceThreshold() const;
+
 	void setParamPort(drumkv1::ParamIndex index, float *pfParam);
 	drumkv1_port *paramPort(drumkv1::ParamIndex index);
 
@@ -25,6 +25,7 @@
 #include "drumkv1_controls.h"
 
 #include <QFileInfo>
+#include <QStandardPaths>
 
 
 //-------------------------------------------------------------------------
@@ -341,6 +342,27 @@ void drumkv1_config::load (void)
 	sTuningKeyMapDir = QSettings::value("/KeyMapDir").toString();
 	sTuningKeyMapFile = QSettings::value("/KeyMapFile").toString();
 	QSettings::endGroup();
+
+	// Engine options.
+	QSettings::beginGroup("/Engine");
+	iVoiceThreads = QSettings::value("/VoiceThreads", 0).toInt();
+	bEffectsThread = QSettings::value("/EffectsThread", false).toBool();
+	iPolyphony = QSettings::value("/Polyphony", 0).toInt();
+	iVoiceSteal = QSettings::value("/VoiceSteal", 0).toInt();
+	iSilenceHold = QSettings::value("/SilenceHold", 100).toInt();
+	bSampleCache = QSettings::value("/SampleCache", true).toBool();
+	sSampleCacheDir = QSettings::value("/SampleCacheDir").toString();
+	if (sSampleCacheDir.isEmpty()) {
+		sSampleCacheDir = QStandardPaths::writableLocation(
+			QStandardPaths::GenericCacheLocation);
+		sSampleCacheDir += "/" DRUMKV1_TITLE "/samples";
+	}
+	iSampleCacheSize = QSettings::value("/SampleCacheSize", 2048).toInt();
+	bSampleStreaming = QSettings::value("/SampleStreaming", false).toBool();
+	iResampleQuality = QSettings::value("/ResampleQuality", 1).toInt();
+	iSampleFormat = QSettings::value("/SampleFormat", 0).toInt();
+	bSampleLock = QSettings::value("/SampleLock", false).toBool();
+	QSettings::endGroup();
 }
 
 
@@ -384,6 +406,22 @@ void drumkv1_config::save (void)
 	QSettings::setValue("/KeyMapFile", sTuningKeyMapFile);
 	QSettings::endGroup();
 
+	// Engine options.
+	QSettings::beginGroup("/Engine");
+	QSettings::setValue("/VoiceThreads", iVoiceThreads);
+	QSettings::setValue("/EffectsThread", bEffectsThread);
+	QSettings::setValue("/Polyphony", iPolyphony);
+	QSettings::setValue("/VoiceSteal", iVoiceSteal);
+	QSettings::setValue("/SilenceHold", iSilenceHold);
+	QSettings::setValue("/SampleCache", bSampleCache);
+	QSettings::setValue("/SampleCacheDir", sSampleCacheDir);
+	QSettings::setValue("/SampleCacheSize", iSampleCacheSize);
+	QSettings::setValue("/SampleStreaming", bSampleStreaming);
+	QSettings::setValue("/ResampleQuality", iResampleQuality);
+	QSettings::setValue("/SampleFormat", iSampleFormat);
+	QSettings::setValue("/SampleLock", bSampleLock);
+	QSettings::endGroup();
+
 	QSettings::sync();
 }
 
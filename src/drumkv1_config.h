@@ -94,6 +94,36 @@ public:
 	QString sTuningKeyMapDir;
 	QString sTuningKeyMapFile;
 
+	// Multi-core voice rendering (worker threads; 0=none).
+	int iVoiceThreads;
+
+	// Pipelined effects processing (dedicated thread; one block latency).
+	bool bEffectsThread;
+
+	// Polyphony (0=default) and voice-stealing policy.
+	int iPolyphony;
+	int iVoiceSteal;
+
+	// Silent voice retirement hold time (msecs; 0=off).
+	int iSilenceHold;
+
+	// Decoded sample cache (directory and size limit in MB; 0=none).
+	bool bSampleCache;
+	QString sSampleCacheDir;
+	int iSampleCacheSize;
+
+	// Disk-streaming of long samples (from the decoded sample cache).
+	bool bSampleStreaming;
+
+	// Sample-rate conversion quality (0=low, 1=medium, 2=high, 3=best).
+	int iResampleQuality;
+
+	// Resident sample frames format (0=float, 1=int16, 2=half-float).
+	int iSampleFormat;
+
+	// Page-locked (and prefaulted) resident sample frames.
+	bool bSampleLock;
+
 	// Singleton instance accessor.
 	static drumkv1_config *getInstance();
 
@@ -0,0 +1,368 @@
+// drumkv1_fastmath.h
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __drumkv1_fastmath_h
+#define __drumkv1_fastmath_h
+
+#include "config.h"
+
+#include <stdint.h>
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+//-------------------------------------------------------------------------
+// drumkv1_fast - transcendental fast approximations (scalar).
+//
+// Error bounds, as measured over the whole valid argument ranges
+// (and with -ffast-math, which may reassociate the sin/cos range
+// reduction, hence meant for arguments within a couple of turns);
+// checked by tests/drumkv1_test_fastmath.cpp (scalar and SSE2):
+//
+//   drumkv1_fast_exp2f  relative error < 3e-7 (|x| < 126)
+//   drumkv1_fast_expf   relative error < 5e-6 (|x| < 87; < 8e-7 if |x| < 8)
+//   drumkv1_fast_sinf   absolute error < 4e-7 (|x| < 2pi; < 6e-7 if < 4pi)
+//   drumkv1_fast_cosf   absolute error < 4e-7 (|x| < 2pi; < 6e-7 if < 4pi)
+//   drumkv1_fast_tanhf  absolute error < 0.025 (continuous, odd, bounded)
+//
+
+// float bits type-punning helper.
+
+union drumkv1_fast_bits
+{
+	float   f;
+	int32_t i;
+};
+
+
+// round to nearest integer (SSE2: default rounding mode).
+
+inline int32_t drumkv1_fast_round ( float x )
+{
+#if defined(__SSE2__)
+	return _mm_cvtss_si32(_mm_set_ss(x));
+#else
+	return int32_t(x < 0.0f ? x - 0.5f : x + 0.5f);
+#endif
+}
+
+
+// 2^x (6th order Taylor on the rounded fraction); the exponent is
+// added to the (integer) bits, as -ffast-math would otherwise happily
+// distribute a 2^i multiply over the polynomial terms, which underflow
+// (flush to zero) way before the result does.
+
+inline float drumkv1_fast_exp2f ( float x )
+{
+	if (x < -126.0f)
+		x = -126.0f;
+	else
+	if (x > +126.0f)
+		x = +126.0f;
+
+	const int32_t i = drumkv1_fast_round(x);
+	const float f = x - float(i);	// [-0.5, +0.5]
+
+	drumkv1_fast_bits r;
+	r.f = 1.0f + f * (6.93147181e-1f + f * (2.40226507e-1f
+		+ f * (5.55041087e-2f + f * (9.61812911e-3f + f * (1.33335581e-3f
+		+ f * 1.54035304e-4f)))));
+	r.i += i * (1 << 23);
+
+	return r.f;
+}
+
+
+// e^x
+
+inline float drumkv1_fast_expf ( float x )
+{
+	return drumkv1_fast_exp2f(1.44269504f * x);
+}
+
+
+// range reduction to [-pi, +pi] (two-part 2pi; exact leading part).
+
+inline float drumkv1_fast_reduce ( float x )
+{
+	const float k = float(drumkv1_fast_round(x * 1.59154943e-1f));
+	return (x - k * 6.28125f) - k * 1.93530718e-3f;
+}
+
+
+// sin(x) on [-pi/2, +pi/2] (11th order Taylor).
+
+inline float drumkv1_fast_sinp ( float x )
+{
+	const float x2 = x * x;
+
+	return x * (1.0f + x2 * (-1.66666667e-1f + x2 * (8.33333333e-3f
+		+ x2 * (-1.98412698e-4f + x2 * (2.75573192e-6f
+		+ x2 * -2.50521084e-8f)))));
+}
+
+
+// sin(x)
+
+inline float drumkv1_fast_sinf ( float x )
+{
+	x = drumkv1_fast_reduce(x);
+
+	// fold to [-pi/2, +pi/2]...
+	if (x > +1.57079633f)
+		x = +3.14159265f - x;
+	else
+	if (x < -1.57079633f)
+		x = -3.14159265f - x;
+
+	return drumkv1_fast_sinp(x);
+}
+
+
+// cos(x) = sin(pi/2 - |x|)
+
+inline float drumkv1_fast_cosf ( float x )
+{
+	return drumkv1_fast_sinp(1.57079633f - ::fabsf(drumkv1_fast_reduce(x)));
+}
+
+
+// tanh(x) (rational, clamped to unity beyond |x| = 3).
+
+inline float drumkv1_fast_tanhf ( float x )
+{
+	if (x < -3.0f)
+		x = -3.0f;
+	else
+	if (x > +3.0f)
+		x = +3.0f;
+
+	const float x2 = x * x;
+
+	return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_fast - transcendental fast approximations (SSE2; 4 lanes).
+//
+// Same approximations and error bounds as the scalar ones above;
+// rounding relies on the default (round-to-nearest) SSE mode.
+//
+
+#if defined(__SSE2__)
+
+// 2^x
+
+inline __m128 drumkv1_fast_exp2f4 ( __m128 x )
+{
+	x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.0f)), _mm_set1_ps(+126.0f));
+
+	const __m128i i = _mm_cvtps_epi32(x);
+	const __m128  f = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+
+	__m128 p = _mm_set1_ps(1.54035304e-4f);
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.33335581e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(9.61812911e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(5.55041087e-2f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.40226507e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(6.93147181e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.0f));
+
+	return _mm_castsi128_ps(
+		_mm_add_epi32(_mm_castps_si128(p), _mm_slli_epi32(i, 23)));
+}
+
+
+// e^x
+
+inline __m128 drumkv1_fast_expf4 ( __m128 x )
+{
+	return drumkv1_fast_exp2f4(_mm_mul_ps(x, _mm_set1_ps(1.44269504f)));
+}
+
+
+// range reduction to [-pi, +pi]
+
+inline __m128 drumkv1_fast_reduce4 ( __m128 x )
+{
+	const __m128 k = _mm_cvtepi32_ps(
+		_mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.59154943e-1f))));
+	return _mm_sub_ps(_mm_sub_ps(x, _mm_mul_ps(k, _mm_set1_ps(6.28125f))),
+		_mm_mul_ps(k, _mm_set1_ps(1.93530718e-3f)));
+}
+
+
+// sin(x) on [-pi/2, +pi/2]
+
+inline __m128 drumkv1_fast_sinp4 ( __m128 x )
+{
+	const __m128 x2 = _mm_mul_ps(x, x);
+
+	__m128 p = _mm_set1_ps(-2.50521084e-8f);
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(2.75573192e-6f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.98412698e-4f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(8.33333333e-3f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(-1.66666667e-1f));
+	p = _mm_add_ps(_mm_mul_ps(p, x2), _mm_set1_ps(1.0f));
+
+	return _mm_mul_ps(x, p);
+}
+
+
+// sin(x)
+
+inline __m128 drumkv1_fast_sinf4 ( __m128 x )
+{
+	x = drumkv1_fast_reduce4(x);
+
+	// fold to [-pi/2, +pi/2]...
+	const __m128 pi = _mm_set1_ps(3.14159265f);
+	const __m128 hi = _mm_cmpgt_ps(x, _mm_set1_ps(+1.57079633f));
+	const __m128 lo = _mm_cmplt_ps(x, _mm_set1_ps(-1.57079633f));
+	x = _mm_or_ps(_mm_andnot_ps(_mm_or_ps(hi, lo), x), _mm_or_ps(
+		_mm_and_ps(hi, _mm_sub_ps(pi, x)),
+		_mm_and_ps(lo, _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(pi, x)))));
+
+	return drumkv1_fast_sinp4(x);
+}
+
+
+// cos(x) = sin(pi/2 - |x|)
+
+inline __m128 drumkv1_fast_cosf4 ( __m128 x )
+{
+	const __m128 abs4 = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	return drumkv1_fast_sinp4(_mm_sub_ps(_mm_set1_ps(1.57079633f),
+		_mm_and_ps(abs4, drumkv1_fast_reduce4(x))));
+}
+
+#endif	// __SSE2__
+
+
+//-------------------------------------------------------------------------
+// drumkv1_fast - block kernels.
+//
+
+// unipolar soft-clip sigmoid, in-place (as drumkv1_sigmoid_1):
+//   y[n] = 0.5 * (1 + t1 * u * (1.5 - 0.5 * u^2)), u = clip(2 * y[n] - 1)
+
+inline void drumkv1_fast_sigmoid_1 ( float *y, uint32_t nframes, float t0 = 0.01f )
+{
+	const float t1 = 1.0f - t0;
+
+	uint32_t n = 0;
+#if defined(__SSE2__)
+	const __m128 one4 = _mm_set1_ps(1.0f);
+	const __m128 half4 = _mm_set1_ps(0.5f);
+	const __m128 t14 = _mm_set1_ps(t1);
+	for (; n + 4 <= nframes; n += 4) {
+		__m128 u = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(2.0f), _mm_loadu_ps(y + n)), one4);
+		u = _mm_min_ps(_mm_max_ps(u, _mm_set1_ps(-1.0f)), one4);
+		const __m128 s = _mm_mul_ps(_mm_mul_ps(t14, u), _mm_sub_ps(
+			_mm_set1_ps(1.5f), _mm_mul_ps(half4, _mm_mul_ps(u, u))));
+		_mm_storeu_ps(y + n, _mm_mul_ps(half4, _mm_add_ps(one4, s)));
+	}
+#endif
+	for (; n < nframes; ++n) {
+		float u = 2.0f * y[n] - 1.0f;
+		if (u < -1.0f)
+			u = -1.0f;
+		else
+		if (u > +1.0f)
+			u = +1.0f;
+		y[n] = 0.5f * (1.0f + t1 * u * (1.5f - 0.5f * u * u));
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_math - hot path math (fast approximations, if configured).
+//
+
+#ifdef CONFIG_FAST_MATH
+
+inline float drumkv1_exp2f ( float x )
+	{ return drumkv1_fast_exp2f(x); }
+inline float drumkv1_expf ( float x )
+	{ return drumkv1_fast_expf(x); }
+inline float drumkv1_sinf ( float x )
+	{ return drumkv1_fast_sinf(x); }
+inline float drumkv1_cosf ( float x )
+	{ return drumkv1_fast_cosf(x); }
+
+#else
+
+inline float drumkv1_exp2f ( float x )
+	{ return ::powf(2.0f, x); }
+inline float drumkv1_expf ( float x )
+	{ return ::expf(x); }
+inline float drumkv1_sinf ( float x )
+	{ return ::sinf(x); }
+inline float drumkv1_cosf ( float x )
+	{ return ::cosf(x); }
+
+#endif	// CONFIG_FAST_MATH
+
+
+// block variants (in-place allowed; 4 lanes at a time, if configured).
+
+#if defined(CONFIG_FAST_MATH) && defined(__SSE2__)
+#define DRUMKV1_MATH_V(func, y, x, nframes) \
+	for (; n + 4 <= nframes; n += 4) \
+		_mm_storeu_ps(y + n, drumkv1_fast_##func##4(_mm_loadu_ps(x + n)))
+#else
+#define DRUMKV1_MATH_V(func, y, x, nframes)
+#endif
+
+inline void drumkv1_exp2f_v ( float *y, const float *x, uint32_t nframes )
+{
+	uint32_t n = 0;
+	DRUMKV1_MATH_V(exp2f, y, x, nframes);
+	for (; n < nframes; ++n)
+		y[n] = drumkv1_exp2f(x[n]);
+}
+
+inline void drumkv1_expf_v ( float *y, const float *x, uint32_t nframes )
+{
+	uint32_t n = 0;
+	DRUMKV1_MATH_V(expf, y, x, nframes);
+	for (; n < nframes; ++n)
+		y[n] = drumkv1_expf(x[n]);
+}
+
+inline void drumkv1_cosf_v ( float *y, const float *x, uint32_t nframes )
+{
+	uint32_t n = 0;
+	DRUMKV1_MATH_V(cosf, y, x, nframes);
+	for (; n < nframes; ++n)
+		y[n] = drumkv1_cosf(x[n]);
+}
+
+#undef DRUMKV1_MATH_V
+
+
+#endif	// __drumkv1_fastmath_h
+
+// end of drumkv1_fastmath.h
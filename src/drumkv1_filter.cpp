@@ -0,0 +1,42 @@
+// drumkv1_filter.cpp
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "drumkv1_filter.h"
+
+
+//-------------------------------------------------------------------------
+// drumkv1_filter3 - RBJ biquad filter implementation.
+//
+
+// half-angle sin/cos table (shared; built once, on load).
+drumkv1_filter3::Table drumkv1_filter3::g_table;
+
+drumkv1_filter3::Table::Table (void)
+{
+	for (uint32_t i = 0; i < TABLE_SIZE + 2; ++i) {
+		const double w = 0.5 * M_PI * double(i) / double(TABLE_SIZE);
+		hsin[i] = float(::sin(w));
+		hcos[i] = float(::cos(w));
+	}
+}
+
+
+// end of drumkv1_filter.cpp
@@ -167,6 +167,9 @@ private:
 // drumkv1_filter3 - RBJ biquad filter implementation.
 //
 //   http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
+//
+// -- coeffs. from a shared, linear-interpolated half-angle sin/cos
+//    table (cheap enough to follow per-sample cutoff modulation).
 
 class drumkv1_filter3
 {
@@ -215,54 +218,63 @@ public:
 		return out;
 	}
 
+	// half-angle table size (steps over [0, pi/2]).
+	static const uint32_t TABLE_SIZE = 1024;
+
 protected:
 
 	void reset()
 	{
-		const float q = 2.0f * m_reso * m_reso + 1.0f;
-
-		const float omega = M_PI * m_cutoff;
-		const float tsin  = ::sinf(omega);
-		const float tcos  = ::cosf(omega);
-		const float alpha = tsin / (2.0f * q);
-
-		// temp vars
-		const float a0 =  1.0f + alpha;
-		const float a1 = -2.0f * tcos;
-		const float a2 =  1.0f - alpha;
-
-		float b0, b1, b2;
+		// half-angle sin/cos (omega = pi * cutoff)...
+		float x = m_cutoff * float(TABLE_SIZE);
+		if (x < 0.0f)
+			x = 0.0f;
+		else
+		if (x > float(TABLE_SIZE))
+			x = float(TABLE_SIZE);
+		const uint32_t i = uint32_t(x);
+		const float d = x - float(i);
+		const float *ts = g_table.hsin + i;
+		const float *tc = g_table.hcos + i;
+		const float hsin = ts[0] + d * (ts[1] - ts[0]);
+		const float hcos = tc[0] + d * (tc[1] - tc[0]);
+
+		// temp vars (normalized: interpolation falls off the unit circle)
+		const float hsin2 = hsin * hsin;
+		const float hcos2 = hcos * hcos;
+		const float hnorm = hsin2 + hcos2;
+
+		// 1 / a0 = 1 / (1 + alpha), alpha = tsin / (2 * q)
+		const float q2 = 4.0f * m_reso * m_reso + 2.0f;
+		const float k  = q2 / (q2 * hnorm + 2.0f * hsin * hcos);
+		const float a0 = k * hnorm;
 
 		switch (m_type) {
 		case Notch:
-			b0 =  1.0f;
-			b1 = -2.0f * tcos;
-			b2 =  1.0f;
+			m_b0a0 =  a0;
+			m_b1a0 = -2.0f * (hcos2 - hsin2) * k;	// -2 * tcos
+			m_b2a0 =  a0;
 			break;
 		case High:
-			b0 = (1.0f + tcos) / 2.0f;
-			b1 = -1.0f - tcos;
-			b2 =  b0;
+			m_b0a0 =  hcos2 * k;	// (1 + tcos) / 2
+			m_b1a0 = -2.0f * m_b0a0;
+			m_b2a0 =  m_b0a0;
 			break;
 		case Band:
-			b0 =  tsin / 2.0f;
-			b1 =  0.0f;
-			b2 = -b0;
+			m_b0a0 =  hsin * hcos * k;	// tsin / 2
+			m_b1a0 =  0.0f;
+			m_b2a0 = -m_b0a0;
 			break;
 		case Low:
 		default:
-			b0 = (1.0f - tcos) / 2.0f;
-			b1 =  1.0f - tcos;
-			b2 =  b0;
+			m_b0a0 =  hsin2 * k;	// (1 - tcos) / 2
+			m_b1a0 =  2.0f * m_b0a0;
+			m_b2a0 =  m_b0a0;
 			break;
 		}
 
-		// set filter coeffs
-		m_b0a0 = b0 / a0;
-		m_b1a0 = b1 / a0;
-		m_b2a0 = b2 / a0;
-		m_a1a0 = a1 / a0;
-		m_a2a0 = a2 / a0;
+		m_a1a0 = -2.0f * (hcos2 - hsin2) * k;	// -2 * tcos
+		m_a2a0 =  2.0f * a0 - 1.0f;		// (1 - alpha) / (1 + alpha)
 	}
 
 private:
@@ -279,6 +291,17 @@ private:
 
 	// in/out history
 	float m_out1, m_out2, m_in1, m_in2;
+
+	// half-angle sin/cos table (shared).
+	struct Table
+	{
+		Table();
+
+		float hsin[TABLE_SIZE + 2];
+		float hcos[TABLE_SIZE + 2];
+	};
+
+	static Table g_table;
 };
 
 
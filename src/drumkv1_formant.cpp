@@ -20,6 +20,7 @@
 *****************************************************************************/
 
 #include "drumkv1_formant.h"
+#include "drumkv1_fastmath.h"
 
 
 //---------------------------------------------------------------------
@@ -160,25 +161,46 @@ drumkv1_formant::Vtab *drumkv1_formant::g_vtabs[NUM_VTABS] = {
 };
 
 
-// compute coeffs. for given vocal formant table
+// compute coeffs. for given vocal formant table (all formants)
 void drumkv1_formant::Impl::vtab_coeffs (
-	Coeffs& coeffs, const Vtab *vtab, uint32_t i, float p )
+	Coeffs *coeffs, const Vtab *vtab, float p ) const
 {
-	const float Fi = vtab->freq[i];
-	const float Gi = vtab->gain[i];
-	const float Bi = vtab->band[i] * p;
+	float Ai[NUM_FORMANTS];
+	float Ri[NUM_FORMANTS];
+	float Ci[NUM_FORMANTS];
 
-	const float Ai = ::powf(10.0f, (0.05f * Gi));
-	const float Ri = ::expf(-M_PI * Bi / m_srate);
+	for (uint32_t i = 0; i < NUM_FORMANTS; ++i) {
+		const float Fi = vtab->freq[i];
+		const float Gi = vtab->gain[i];
+		const float Bi = vtab->band[i] * p;
+		Ai[i] = 0.166096405f * Gi;	// log2(10^(0.05 * Gi))
+		Ri[i] = -M_PI * Bi / m_srate;
+		Ci[i] = 2.0f * M_PI * Fi / m_srate;
+	}
+
+	drumkv1_exp2f_v(Ai, Ai, NUM_FORMANTS);
+	drumkv1_expf_v(Ri, Ri, NUM_FORMANTS);
+	drumkv1_cosf_v(Ci, Ci, NUM_FORMANTS);
 
-	coeffs.b2 = Ri * Ri;
-	coeffs.b1 = 2.0f * Ri * ::cosf(2.0f * M_PI * Fi / m_srate);
-	coeffs.a0 = Ai * (1.0f - coeffs.b1 + coeffs.b2);
+	for (uint32_t i = 0; i < NUM_FORMANTS; ++i) {
+		Coeffs& coeff = coeffs[i];
+		coeff.b2 = Ri[i] * Ri[i];
+		coeff.b1 = 2.0f * Ri[i] * Ci[i];
+		coeff.a0 = Ai[i] * (1.0f - coeff.b1 + coeff.b2);
+	}
 }
 
 
 // reset method impl.
 void drumkv1_formant::Impl::reset_coeffs ( float cutoff, float reso )
+{
+	compute_coeffs(m_ctabs, cutoff, reso);
+}
+
+
+// compute coeffs. method impl.
+void drumkv1_formant::Impl::compute_coeffs (
+	Coeffs *ctabs, float cutoff, float reso ) const
 {
 	const float   fK = cutoff * float(NUM_VTABS - 1);
 	const uint32_t k = uint32_t(fK);
@@ -199,11 +221,13 @@ void drumkv1_formant::Impl::reset_coeffs ( float cutoff, float reso )
 	if (k < NUM_VTABS - 1)
 		vtab2 = &g_vtabs[k + 1][0];
 
-	Coeffs coeff2;
+	Coeffs coeffs2[NUM_FORMANTS];
+	vtab_coeffs(ctabs, vtab1, p);
+	vtab_coeffs(coeffs2, vtab2, p);
+
 	for (uint32_t i = 0; i < NUM_FORMANTS; ++i) {
-		Coeffs& coeff1 = m_ctabs[i];
-		vtab_coeffs(coeff1, vtab1, i, p);
-		vtab_coeffs(coeff2, vtab2, i, p);
+		Coeffs& coeff1 = ctabs[i];
+		const Coeffs& coeff2 = coeffs2[i];
 		coeff1.a0 += dJ * (coeff2.a0 - coeff1.a0);
 		coeff1.b1 += dJ * (coeff2.b1 - coeff1.b1);
 		coeff1.b2 += dJ * (coeff2.b2 - coeff1.b2);
@@ -215,9 +239,10 @@ void drumkv1_formant::Impl::reset_coeffs ( float cutoff, float reso )
 void drumkv1_formant::reset_coeffs (void)
 {
 	if (m_pImpl) {
-		m_pImpl->reset_coeffs(m_cutoff, m_reso);
+		Coeffs ctabs[NUM_FORMANTS];
+		m_pImpl->compute_coeffs(ctabs, m_cutoff, m_reso);
 		for (uint32_t i = 0; i < NUM_FORMANTS; ++i)
-			m_filters[i].reset_coeffs(m_pImpl->coeffs(i));
+			m_filters[i].reset_coeffs(ctabs[i]);
 	}
 }
 
@@ -75,10 +75,13 @@ public:
 		// reset coeffs. method
 		void reset_coeffs(float cutoff = 0.5f, float reso = 0.0f);
 
+		// compute coeffs. (re-entrant, shared by voices)
+		void compute_coeffs(Coeffs *ctabs, float cutoff, float reso) const;
+
 	protected:
 
-		// compute coeffs. for given vocal formant table
-		void vtab_coeffs(Coeffs& coeffs, const Vtab *vtab, uint32_t i, float p);
+		// compute coeffs. for given vocal formant table (all formants)
+		void vtab_coeffs(Coeffs *coeffs, const Vtab *vtab, float p) const;
 
 	private:
 
@@ -22,8 +22,11 @@
 #ifndef __drumkv1_fx_h
 #define __drumkv1_fx_h
 
+#include "drumkv1_simd.h"
+
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 
@@ -34,6 +37,65 @@
 //    Copyright (C) 2007 arguru, discodsp.com
 //
 
+//-------------------------------------------------------------------------
+// drumkv1_fx_tail - effect tail tracker (silent input bypass).
+//
+// An effect is processed while its input is not silent, then for as
+// long as its feedback loop keeps ringing above the silence threshold,
+// as estimated from the loudest input peak level, the loop period
+// (frames) and its gain; bypassed afterwards, until input returns.
+
+class drumkv1_fx_tail
+{
+public:
+
+	drumkv1_fx_tail() { reset(); }
+
+	void reset()
+	{
+		m_peak = 0.0f;
+		m_frames = 0.0f;
+	}
+
+	// input peak level (current block); whether to process it.
+	bool process(float peak, uint32_t nframes, float period, float gain)
+	{
+		if (peak > THRESHOLD) {
+			if (m_peak < peak)
+				m_peak = peak;
+			m_frames = 0.0f;
+			return true;
+		}
+
+		if (m_peak < THRESHOLD)
+			return false;
+
+		if (gain < 0.0f)
+			gain = -gain;
+		if (gain < 0.999f) {
+			float npasses = 1.0f;
+			if (gain > 0.001f)
+				npasses += ::logf(THRESHOLD / m_peak) / ::logf(gain);
+			if (m_frames > (period < 1.0f ? 1.0f : period) * npasses) {
+				reset();
+				return false;
+			}
+		}
+
+		m_frames += float(nframes);
+
+		return true;
+	}
+
+	static constexpr float THRESHOLD = 1E-5f;	// -100dBFS
+
+private:
+
+	float m_peak;
+	float m_frames;
+};
+
+
 //-------------------------------------------------------------------------
 // drumkv1_fx_filter - RBJ biquad filter implementation.
 //
@@ -193,6 +255,16 @@ public:
 		return out;
 	}
 
+	// filter coeffs (b0/a0, b1/a0, b2/a0, a1/a0, a2/a0).
+	void coeffs(float *c) const
+	{
+		c[0] = m_b0a0;
+		c[1] = m_b1a0;
+		c[2] = m_b2a0;
+		c[3] = m_a1a0;
+		c[4] = m_a2a0;
+	}
+
 protected:
 
 	void reset()
@@ -217,25 +289,21 @@ private:
 
 //-------------------------------------------------------------------------
 // drumkv1_fx_comp - DiscoDSP's "rock da disco" compressor/eq.
+//
+// -- block processed, stereo-linked (up to 4 channels): the eq. biquad
+//    cascade runs on all channels at once (SSE2 lanes), sharing just
+//    the one gain envelope; no anti-denormal noise (see drumkv1_simd_ftz).
+//
 
 class drumkv1_fx_comp
 {
 public:
 
 	drumkv1_fx_comp(float srate = 44100.0f)
-		: m_srate(srate), m_peak(0.0f),
-			m_attack(0.0f), m_release(0.0f),
-			m_lo(srate), m_mi(srate), m_hi(srate) {}
+		: m_srate(srate) { reset(); }
 
 	void setSampleRate(float srate)
-	{
-		m_srate = srate;
-
-		m_lo.setSampleRate(srate);
-		m_mi.setSampleRate(srate);
-		m_hi.setSampleRate(srate);
-	}
-
+		{ m_srate = srate; }
 	float sampleRate() const
 		{ return m_srate; }
 
@@ -247,41 +315,162 @@ public:
 		m_release = ::expf(-1000.0f / (m_srate * 150.0f));
 
 		// rock-da-house eq.
-		m_lo.reset(drumkv1_fx_filter::Peak,      100.0f, 1.0f, 6.0f);
-		m_mi.reset(drumkv1_fx_filter::LoShelf,  1000.0f, 1.0f, 3.0f);
-		m_hi.reset(drumkv1_fx_filter::HiShelf, 10000.0f, 1.0f, 4.0f);
+		drumkv1_fx_filter lo(m_srate), mi(m_srate), hi(m_srate);
+		lo.reset(drumkv1_fx_filter::Peak,      100.0f, 1.0f, 6.0f);
+		mi.reset(drumkv1_fx_filter::LoShelf,  1000.0f, 1.0f, 3.0f);
+		hi.reset(drumkv1_fx_filter::HiShelf, 10000.0f, 1.0f, 4.0f);
+
+		lo.coeffs(m_coeffs[LO]);
+		mi.coeffs(m_coeffs[MI]);
+		hi.coeffs(m_coeffs[HI]);
+
+		::memset(m_state, 0, sizeof(m_state));
 	}
 
-	void process(float *in, uint32_t nframes)
+	void process(float **ins, uint16_t nchannels, uint32_t nframes)
 	{
-		// compressor
-		const float threshold = 0.251f;	//~= powf(10.0f, -12.0f / 20.0f);
-		const float post_gain = 1.995f;	//~= powf(10.0f, 6.0f / 20.0f);
-		// process buffers
-		for (uint32_t i = 0; i < nframes; ++i) {
-			// anti-denormalizer noise
-			const float ad = 1E-14f * float(::rand());
-			// process
-			const float lo = m_lo.output(m_mi.output(m_hi.output(*in + ad)));
-			// compute peak
-			const float peak = ::fabsf(lo);
-			// compute gain
-			float gain = 1.0f;
-			if (peak > threshold)
-				gain = threshold / peak;
-			// envelope
-			if (m_peak > gain) {
-				m_peak *= m_attack;
-				m_peak += (1.0f - m_attack) * gain;
-			} else {
-				m_peak *= m_release;
-				m_peak += (1.0f - m_release) * gain;
+		if (nchannels > MAX_CHANNELS)
+			nchannels = MAX_CHANNELS;
+
+		uint16_t k, j;
+		uint32_t n, m;
+	#if defined(__SSE2__)
+		// filter coeffs and state (lanes)...
+		__m128 c4[NUM_BIQUADS][5];
+		__m128 s4[NUM_BIQUADS][4];
+		for (j = 0; j < NUM_BIQUADS; ++j) {
+			for (k = 0; k < 5; ++k)
+				c4[j][k] = _mm_set1_ps(m_coeffs[j][k]);
+			for (k = 0; k < 4; ++k)
+				s4[j][k] = _mm_loadu_ps(m_state[j][k]);
+		}
+		const __m128 post4 = _mm_set1_ps(POST_GAIN);
+		const __m128 abs4 = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		// process 4 frames at a time, transposed (channels as lanes)...
+		float buf[MAX_CHANNELS][4];
+		::memset(buf, 0, sizeof(buf));
+		for (n = 0; n < nframes; n += m) {
+			m = nframes - n;
+			if (m > 4)
+				m = 4;
+			for (k = 0; k < nchannels; ++k)
+				::memcpy(buf[k], ins[k] + n, m * sizeof(float));
+			__m128 r[4];
+			r[0] = _mm_loadu_ps(buf[0]);
+			r[1] = _mm_loadu_ps(buf[1]);
+			r[2] = _mm_loadu_ps(buf[2]);
+			r[3] = _mm_loadu_ps(buf[3]);
+			_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+			for (uint32_t t = 0; t < m; ++t) {
+				__m128 y = r[t];
+				for (j = 0; j < NUM_BIQUADS; ++j)
+					y = biquad4(c4[j], s4[j], y);
+				// stereo-linked peak
+				__m128 p = _mm_and_ps(abs4, y);
+				p = _mm_max_ps(p, _mm_movehl_ps(p, p));
+				p = _mm_max_ss(p, _mm_shuffle_ps(p, p, 1));
+				// envelope and output
+				r[t] = _mm_mul_ps(_mm_mul_ps(y,
+					_mm_set1_ps(envelope(_mm_cvtss_f32(p)))), post4);
 			}
-			// output
-			*in++ = lo * m_peak * post_gain;
+			_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+			_mm_storeu_ps(buf[0], r[0]);
+			_mm_storeu_ps(buf[1], r[1]);
+			_mm_storeu_ps(buf[2], r[2]);
+			_mm_storeu_ps(buf[3], r[3]);
+			for (k = 0; k < nchannels; ++k)
+				::memcpy(ins[k] + n, buf[k], m * sizeof(float));
 		}
+		for (j = 0; j < NUM_BIQUADS; ++j) {
+			for (k = 0; k < 4; ++k)
+				_mm_storeu_ps(m_state[j][k], s4[j][k]);
+		}
+	#else
+		for (n = 0; n < nframes; ++n) {
+			float y[MAX_CHANNELS];
+			float peak = 0.0f;
+			for (k = 0; k < nchannels; ++k) {
+				y[k] = ins[k][n];
+				for (j = 0; j < NUM_BIQUADS; ++j)
+					y[k] = biquad(m_coeffs[j], m_state[j], k, y[k]);
+				const float a = ::fabsf(y[k]);
+				if (peak < a)
+					peak = a;
+			}
+			const float gain = envelope(peak);
+			for (k = 0; k < nchannels; ++k)
+				ins[k][n] = y[k] * gain * POST_GAIN;
+		}
+		(void) m;
+	#endif
+		// flush denormal state (block-wise)...
+		for (j = 0; j < NUM_BIQUADS; ++j) {
+			for (k = 0; k < 4; ++k) {
+				for (uint16_t i = 0; i < MAX_CHANNELS; ++i)
+					m_state[j][k][i] = drumkv1_simd_denormal(m_state[j][k][i]);
+			}
+		}
+		m_peak = drumkv1_simd_denormal(m_peak);
 	}
 
+	static const uint16_t MAX_CHANNELS = 4;
+
+protected:
+
+	// eq. cascade order (hi, mi, lo).
+	enum { HI = 0, MI, LO, NUM_BIQUADS };
+
+	// compressor gain envelope (linked peak).
+	float envelope(float peak)
+	{
+		// compute gain
+		float gain = 1.0f;
+		if (peak > THRESHOLD)
+			gain = THRESHOLD / peak;
+		// envelope
+		if (m_peak > gain) {
+			m_peak *= m_attack;
+			m_peak += (1.0f - m_attack) * gain;
+		} else {
+			m_peak *= m_release;
+			m_peak += (1.0f - m_release) * gain;
+		}
+		return m_peak;
+	}
+
+#if defined(__SSE2__)
+	// biquad (4 lanes; state: in1, in2, out1, out2).
+	static __m128 biquad4(const __m128 *c, __m128 *s, __m128 x)
+	{
+		const __m128 y = _mm_sub_ps(_mm_sub_ps(_mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(c[0], x),
+			_mm_mul_ps(c[1], s[0])), _mm_mul_ps(c[2], s[1])),
+			_mm_mul_ps(c[3], s[2])), _mm_mul_ps(c[4], s[3]));
+		s[1] = s[0];
+		s[0] = x;
+		s[3] = s[2];
+		s[2] = y;
+		return y;
+	}
+#else
+	// biquad (lane k; state: in1, in2, out1, out2).
+	static float biquad(const float *c, float s[4][MAX_CHANNELS],
+		uint16_t k, float x)
+	{
+		const float y = c[0] * x
+			+ c[1] * s[0][k] + c[2] * s[1][k]
+			- c[3] * s[2][k] - c[4] * s[3][k];
+		s[1][k] = s[0][k];
+		s[0][k] = x;
+		s[3][k] = s[2][k];
+		s[2][k] = y;
+		return y;
+	}
+#endif
+
+	static constexpr float THRESHOLD = 0.251f;	//~= powf(10.0f, -12.0f / 20.0f);
+	static constexpr float POST_GAIN = 1.995f;	//~= powf(10.0f, 6.0f / 20.0f);
+
 private:
 
 	float m_srate;
@@ -290,7 +479,192 @@ private:
 	float m_attack;
 	float m_release;
 
-	drumkv1_fx_filter m_lo, m_mi, m_hi;
+	float m_coeffs[NUM_BIQUADS][5];
+	float m_state[NUM_BIQUADS][4][MAX_CHANNELS];
+};
+
+
+//-------------------------------------------------------------------------
+// drumkv1_fx_limiter - stereo-linked lookahead (brick-wall) limiter.
+//
+// -- the gain needed for each (driven, linked) peak is held as the
+//    minimum over the lookahead window, released smoothly and then
+//    averaged over the lookahead length, so that it is fully reached
+//    by the time the peak leaves the (lookahead) delay line.
+// -- bypassed altogether when disabled (no lookahead latency);
+//    the delay line is flushed when enabled again.
+//
+
+class drumkv1_fx_limiter
+{
+public:
+
+	drumkv1_fx_limiter(float srate = 44100.0f)
+		: m_srate(srate), m_enabled(false) { reset(); }
+
+	void setSampleRate(float srate)
+		{ m_srate = srate; }
+	float sampleRate() const
+		{ return m_srate; }
+
+	void reset()
+	{
+		m_nlookahead = uint32_t(0.001f * LOOKAHEAD_MSECS * m_srate);
+		if (m_nlookahead < 1)
+			m_nlookahead = 1;
+		else
+		if (m_nlookahead > MAX_LOOKAHEAD)
+			m_nlookahead = MAX_LOOKAHEAD;
+
+		m_release = ::expf(-1000.0f / (m_srate * RELEASE_MSECS));
+
+		clear();
+	}
+
+	// lookahead latency (frames), when enabled.
+	uint32_t latency() const
+		{ return m_nlookahead; }
+
+	// in-place; lookahead delayed and limited, if enabled.
+	void process(float **ins, uint16_t nchannels, uint32_t nframes, bool enabled)
+	{
+		if (!enabled) {
+			m_enabled = false;
+			return;
+		}
+
+		if (!m_enabled) {
+			m_enabled = true;
+			clear();
+		}
+
+		if (nchannels > MAX_CHANNELS)
+			nchannels = MAX_CHANNELS;
+
+		const double scale = 1.0 / double(m_nlookahead);
+
+		for (uint32_t n = 0; n < nframes; ++n) {
+			// linked (driven) peak and its gain...
+			float peak = 0.0f;
+			for (uint16_t k = 0; k < nchannels; ++k) {
+				const float a = ::fabsf(ins[k][n]);
+				if (peak < a)
+					peak = a;
+			}
+			peak *= DRIVE;
+			float gain = 1.0f;
+			if (peak > CEILING)
+				gain = CEILING / peak;
+			// lookahead minimum, release and average...
+			gain = average(release(minimum(gain)), scale);
+			// lookahead delay...
+			float *delay = m_delay[m_index];
+			for (uint16_t k = 0; k < nchannels; ++k) {
+				float *in = ins[k] + n;
+				const float out = delay[k];
+				delay[k] = *in;
+				*in = out * DRIVE * gain;
+			}
+			if (++m_index >= m_nlookahead)
+				m_index = 0;
+		}
+	}
+
+	static const uint16_t MAX_CHANNELS = 4;
+	static const uint32_t MAX_LOOKAHEAD = 256;
+
+protected:
+
+	// flush the lookahead delay line and gain state.
+	void clear()
+	{
+		::memset(m_delay, 0, sizeof(m_delay));
+		m_index = 0;
+
+		for (uint32_t i = 0; i < MAX_LOOKAHEAD + 2; ++i) {
+			m_queue[i].gain  = 1.0f;
+			m_queue[i].frame = 0;
+		}
+		m_frame = 0;
+		m_head = m_count = 0;
+
+		for (uint32_t i = 0; i < MAX_LOOKAHEAD; ++i)
+			m_box[i] = 1.0f;
+		m_sum = double(m_nlookahead);
+		m_hold = 1.0f;
+	}
+
+	// sliding minimum over the lookahead window (monotonic queue).
+	float minimum(float gain)
+	{
+		const uint32_t nsize = MAX_LOOKAHEAD + 2;
+		while (m_count > 0) {
+			const uint32_t i = (m_head + m_count - 1) % nsize;
+			if (m_queue[i].gain < gain)
+				break;
+			--m_count;
+		}
+		const uint32_t i = (m_head + m_count) % nsize;
+		m_queue[i].gain  = gain;
+		m_queue[i].frame = m_frame;
+		++m_count;
+		// expire the oldest (never the last) entry; the unsigned
+		// difference stays valid across frame counter wrap-around.
+		if (m_count > 1 && m_frame - m_queue[m_head].frame > m_nlookahead) {
+			if (++m_head >= nsize)
+				m_head = 0;
+			--m_count;
+		}
+		++m_frame;
+		return m_queue[m_head].gain;
+	}
+
+	// smooth release (never above the held minimum).
+	float release(float gain)
+	{
+		if (m_hold > gain)
+			m_hold = gain;
+		else
+			m_hold = gain + (m_hold - gain) * m_release;
+		return m_hold;
+	}
+
+	// moving average over the lookahead length.
+	float average(float gain, double scale)
+	{
+		float& box = m_box[m_index];
+		m_sum += double(gain) - double(box);
+		box = gain;
+		return float(m_sum * scale);
+	}
+
+	static constexpr float LOOKAHEAD_MSECS = 1.0f;
+	static constexpr float RELEASE_MSECS = 50.0f;
+
+	static constexpr float DRIVE   = 2.0f;	// +6dB (as the former sigmoid)
+	static constexpr float CEILING = 0.98f;	// ~-0.2dBFS
+
+private:
+
+	float m_srate;
+
+	uint32_t m_nlookahead;
+
+	float m_release;
+
+	bool m_enabled;
+
+	float m_delay[MAX_LOOKAHEAD][MAX_CHANNELS];
+	uint32_t m_index;
+
+	struct { float gain; uint32_t frame; } m_queue[MAX_LOOKAHEAD + 2];
+	uint32_t m_frame;
+	uint32_t m_head;
+	uint32_t m_count;
+
+	float m_box[MAX_LOOKAHEAD];
+	double m_sum;
+	float m_hold;
 };
 
 
@@ -311,8 +685,13 @@ public:
 			m_buffer[i] = 0.0f;
 
 		m_frames = 0;
+
+		m_tail.reset();
 	}
 
+	bool active(float peak, uint32_t nframes, float delay, float feedb)
+		{ return m_tail.process(peak, nframes, delay * float(MAX_SIZE), feedb); }
+
 	float output(float in, float delay, float feedb)
 	{
 		// calculate delay offset
@@ -366,6 +745,8 @@ private:
 	float m_buffer[MAX_SIZE];
 
 	uint32_t m_frames;
+
+	drumkv1_fx_tail m_tail;
 };
 
 
@@ -390,6 +771,14 @@ public:
 		m_flang2.reset();
 
 		m_lfo = 0.0f;
+
+		m_tail.reset();
+	}
+
+	bool active(float peak, uint32_t nframes, float delay, float feedb)
+	{
+		return m_tail.process(peak, nframes,
+			0.5f * delay * float(drumkv1_fx_flanger::MAX_SIZE), 0.95f * feedb);
 	}
 
 	void process(float *in1, float *in2, uint32_t nframes,
@@ -437,6 +826,8 @@ private:
 	drumkv1_fx_flanger m_flang2;
 
 	float m_lfo;
+
+	drumkv1_fx_tail m_tail;
 };
 
 
@@ -462,6 +853,15 @@ public:
 
 		m_out = 0.0f;
 		m_frames = 0;
+
+		m_tail.reset();
+	}
+
+	bool active(float peak, uint32_t nframes,
+		float delay, float feedb, float bpm = 0.0f)
+	{
+		return m_tail.process(peak, nframes,
+			float(delay_frames(delay, bpm)), 0.95f * feedb);
 	}
 
 	void process(float *in, uint32_t nframes,
@@ -471,18 +871,8 @@ public:
 			return;
 		// constrained feedback
 		feedb *= 0.95f;
-		// calculate delay time
-		float delay_time = delay * m_srate;
-		if (bpm > 0.0f)
-			delay_time *= 60.f / bpm;
 		// set integer delay
-		uint32_t ndelay = uint32_t(delay_time);
-		// clamp
-		if (ndelay < MIN_SIZE)
-			ndelay = MIN_SIZE;
-		else
-		if (ndelay > MAX_SIZE)
-			ndelay = MAX_SIZE;
+		const uint32_t ndelay = delay_frames(delay, bpm);
 		// delay process
 		for (uint32_t i = 0; i < nframes; ++i) {
 			const uint32_t j = (m_frames++) & MAX_MASK;
@@ -496,6 +886,25 @@ public:
 	static const uint32_t MAX_SIZE = (1 << 16);	//= 65536;
 	static const uint32_t MAX_MASK = MAX_SIZE - 1;
 
+protected:
+
+	uint32_t delay_frames(float delay, float bpm) const
+	{
+		// calculate delay time
+		float delay_time = delay * m_srate;
+		if (bpm > 0.0f)
+			delay_time *= 60.f / bpm;
+		// set integer delay
+		uint32_t ndelay = uint32_t(delay_time);
+		// clamp
+		if (ndelay < MIN_SIZE)
+			ndelay = MIN_SIZE;
+		else
+		if (ndelay > MAX_SIZE)
+			ndelay = MAX_SIZE;
+		return ndelay;
+	}
+
 private:
 
 	float m_srate;
@@ -504,6 +913,8 @@ private:
 	float m_out;
 
 	uint32_t m_frames;
+
+	drumkv1_fx_tail m_tail;
 };
 
 
@@ -557,6 +968,16 @@ public:
 		// reset taps
 		for (uint16_t n = 0; n < MAX_TAPS; ++n)
 			m_taps[n].reset();
+		// reset tail
+		m_tail.reset();
+	}
+
+	bool active(float peak, uint32_t nframes, float feedb)
+	{
+		// slowest all-pass taps group delay (lowest sweep)...
+		const float delay_min = 2.0f * 440.0f / m_srate;
+		return m_tail.process(peak, nframes,
+			2.0f * float(MAX_TAPS) / delay_min, feedb);
 	}
 
 	void process(float *in, uint32_t nframes, float wet,
@@ -613,6 +1034,8 @@ private:
 	float m_depth;
 
 	float m_out;
+
+	drumkv1_fx_tail m_tail;
 };
 
 
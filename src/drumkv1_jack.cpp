@@ -35,6 +35,7 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QTimer>
 
 
 #ifdef CONFIG_ALSA_MIDI
@@ -117,12 +118,24 @@ int drumkv1_jack_process ( jack_nframes_t nframes, void *arg )
 
 static int drumkv1_jack_buffer_size ( jack_nframes_t nframes, void *arg )
 {
-	static_cast<drumkv1_jack *> (arg)->setBufferSize(nframes);
+	drumkv1_jack *pDrumk = static_cast<drumkv1_jack *> (arg);
+	pDrumk->setBufferSize(nframes);
+	pDrumk->setNominalBufferSize(nframes);
 
 	return 0;
 }
 
 
+//----------------------------------------------------------------------
+// JACK latency callback.
+
+static void drumkv1_jack_latency (
+	jack_latency_callback_mode_t mode, void *arg )
+{
+	static_cast<drumkv1_jack *> (arg)->latencyEvent(mode);
+}
+
+
 //----------------------------------------------------------------------
 // JACK on-shutdown callback.
 
@@ -158,7 +171,7 @@ static void drumkv1_jack_session_event (
 // drumkv1_jack - impl.
 //
 
-drumkv1_jack::drumkv1_jack (void) : drumkv1(2)
+drumkv1_jack::drumkv1_jack ( int nvoices ) : drumkv1(2)
 {
 	m_client = nullptr;
 
@@ -171,6 +184,13 @@ drumkv1_jack::drumkv1_jack (void) : drumkv1(2)
 
 	::memset(m_params, 0, drumkv1::NUM_PARAMS * sizeof(float));
 
+	m_latency = 0;
+
+	m_nevents = 0;
+	m_noffset = 0;
+	m_ntime   = 0;
+	m_nbuffer = 0;
+
 #ifdef CONFIG_JACK_MIDI
 	m_midi_in = nullptr;
 #endif
@@ -186,6 +206,9 @@ drumkv1_jack::drumkv1_jack (void) : drumkv1(2)
 	drumkv1::programs()->enabled(true);
 	drumkv1::controls()->enabled(true);
 
+	if (nvoices > 0)
+		drumkv1::setPolyphony(nvoices);
+
 	open(DRUMKV1_TITLE);
 	activate();
 }
@@ -226,7 +249,10 @@ int drumkv1_jack::process ( jack_nframes_t nframes )
 			drumkv1::setTempo(host_bpm);
 	}
 
-	uint32_t ndelta = 0;
+	m_nevents = 0;
+	m_noffset = 0;
+	m_ntime   = 0;
+	m_nbuffer = 0;
 
 #ifdef CONFIG_JACK_MIDI
 	void *midi_in = ::jack_port_get_buffer(m_midi_in, nframes);
@@ -235,25 +261,14 @@ int drumkv1_jack::process ( jack_nframes_t nframes )
 		for (uint32_t n = 0; n < nevents; ++n) {
 			jack_midi_event_t event;
 			::jack_midi_event_get(&event, midi_in, n);
-			if (event.time > ndelta) {
-				const uint32_t nread = event.time - ndelta;
-				if (nread > 0) {
-					drumkv1::process(ins, outs, nread);
-					for (uint16_t k = 0; k < nchannels; ++k) {
-						ins[k]  += nread;
-						outs[k] += nread;
-					}
-				}
-				ndelta = event.time;
-			}
-			drumkv1::process_midi(event.buffer, event.size);
+			process_event(ins, outs, event.time, event.buffer, event.size);
 		}
 	}
 #endif
 #ifdef CONFIG_ALSA_MIDI
 	const jack_nframes_t buffer_size = ::jack_get_buffer_size(m_client);
 	const jack_nframes_t frame_time  = ::jack_last_frame_time(m_client);
-	uint8_t event_buffer[1024];
+	uint8_t event_buffer[MAX_EVENT_BUFFER];
 	jack_midi_event_t event;
 	while (::jack_ringbuffer_peek(m_alsa_buffer,
 			(char *) &event, sizeof(event)) == sizeof(event)) {
@@ -264,30 +279,70 @@ int drumkv1_jack::process ( jack_nframes_t nframes )
 			event_time = 0;
 		else
 			event_time = buffer_size - event_time;
-		if (event_time > ndelta) {
-			const uint32_t nread = event_time - ndelta;
-			if (nread > 0) {
-				drumkv1::process(ins, outs, nread);
-				for (uint16_t k = 0; k < nchannels; ++k) {
-					ins[k]  += nread;
-					outs[k] += nread;
-				}
-			}
-			ndelta = event_time;
-		}
 		::jack_ringbuffer_read_advance(m_alsa_buffer, sizeof(event));
 		::jack_ringbuffer_read(m_alsa_buffer, (char *) event_buffer, event.size);
-		drumkv1::process_midi(event_buffer, event.size);
+		process_event(ins, outs, event_time, event_buffer, event.size, true);
 	}
 #endif // CONFIG_ALSA_MIDI
 
-	if (nframes > ndelta)
-		drumkv1::process(ins, outs, nframes - ndelta);
+	// process the whole (remaining) block at once...
+	process_events(ins, outs, nframes);
 
 	return 0;
 }
 
 
+// timestamped MIDI event queue (sample-accurate processing)
+void drumkv1_jack::process_event ( float **ins, float **outs,
+	uint32_t time, uint8_t *data, uint32_t size, bool copy )
+{
+	if (size > MAX_EVENT_BUFFER)
+		return;
+
+	// keep events in order...
+	if (time < m_ntime)
+		time = m_ntime;
+	m_ntime = time;
+
+	// event queue full? flush up to now...
+	if (m_nevents >= MAX_EVENTS
+		|| (copy && m_nbuffer + size > MAX_EVENT_BUFFER))
+		process_events(ins, outs, time);
+
+	if (copy) {
+		::memcpy(m_event_buffer + m_nbuffer, data, size);
+		data = m_event_buffer + m_nbuffer;
+		m_nbuffer += size;
+	}
+
+	drumkv1::MidiEvent& event = m_events[m_nevents++];
+	event.time = time - m_noffset;
+	event.data = data;
+	event.size = size;
+}
+
+
+void drumkv1_jack::process_events ( float **ins, float **outs, uint32_t time )
+{
+	if (time < m_noffset)
+		time = m_noffset;
+
+	const uint32_t nread = time - m_noffset;
+	if (nread > 0 || m_nevents > 0) {
+		drumkv1::process(ins, outs, nread, m_events, m_nevents);
+		const uint16_t nchannels = drumkv1::channels();
+		for (uint16_t k = 0; k < nchannels; ++k) {
+			ins[k]  += nread;
+			outs[k] += nread;
+		}
+	}
+
+	m_noffset = time;
+	m_nevents = 0;
+	m_nbuffer = 0;
+}
+
+
 void drumkv1_jack::open ( const char *client_id )
 {
 	// init param ports
@@ -355,11 +410,18 @@ void drumkv1_jack::open ( const char *client_id )
 #endif	// CONFIG_ALSA_MIDI
 
 	// setup any local, initial buffers...
-	drumkv1::setBufferSize(::jack_get_buffer_size(m_client));
+	const jack_nframes_t buffer_size = ::jack_get_buffer_size(m_client);
+	drumkv1::setBufferSize(buffer_size);
+	drumkv1::setNominalBufferSize(buffer_size);
+
+	m_latency = drumkv1::latency();
 
 	jack_set_buffer_size_callback(m_client,
 		drumkv1_jack_buffer_size, this);
 
+	::jack_set_latency_callback(m_client,
+		drumkv1_jack_latency, this);
+
 	jack_on_shutdown(m_client,
 		drumkv1_jack_on_shutdown, this);
 
@@ -653,6 +715,47 @@ void drumkv1_jack::updateTuning (void)
 }
 
 
+// JACK latency (pipelined effects) handler.
+void drumkv1_jack::latencyEvent ( jack_latency_callback_mode_t mode )
+{
+	const jack_nframes_t nlatency = drumkv1::latency();
+	const uint16_t nchannels = drumkv1::channels();
+
+	jack_latency_range_t range;
+
+	for (uint16_t k = 0; k < nchannels; ++k) {
+		if (m_audio_ins == nullptr || m_audio_ins[k] == nullptr
+			|| m_audio_outs == nullptr || m_audio_outs[k] == nullptr)
+			continue;
+		if (mode == JackCaptureLatency) {
+			::jack_port_get_latency_range(m_audio_ins[k], mode, &range);
+			range.min += nlatency;
+			range.max += nlatency;
+			::jack_port_set_latency_range(m_audio_outs[k], mode, &range);
+		} else {
+			::jack_port_get_latency_range(m_audio_outs[k], mode, &range);
+			range.min += nlatency;
+			range.max += nlatency;
+			::jack_port_set_latency_range(m_audio_ins[k], mode, &range);
+		}
+	}
+}
+
+
+// JACK latency change check (eg. limiter toggled; non-RT).
+void drumkv1_jack::updateLatency (void)
+{
+	const uint32_t nlatency = drumkv1::latency();
+	if (m_latency == nlatency)
+		return;
+
+	m_latency = nlatency;
+
+	if (m_client && m_activated)
+		::jack_recompute_total_latencies(m_client);
+}
+
+
 void drumkv1_jack::shutdown (void)
 {
 	drumkv1_jack_application *pApp = drumkv1_jack_application::getInstance();
@@ -713,8 +816,8 @@ static void drumkv1_sigterm_handler ( int /*signo*/ )
 
 // Constructor.
 drumkv1_jack_application::drumkv1_jack_application ( int& argc, char **argv )
-	: QObject(nullptr), m_pApp(nullptr), m_bGui(true),
-		m_pDrumk(nullptr), m_pWidget(nullptr)
+	: QObject(nullptr), m_pApp(nullptr), m_bGui(true), m_iPolyphony(0),
+		m_pDrumk(nullptr), m_pWidget(nullptr), m_pLatencyTimer(nullptr)
 	  #ifdef CONFIG_NSM
 		, m_pNsmClient(nullptr)
 	  #endif
@@ -729,6 +832,14 @@ drumkv1_jack_application::drumkv1_jack_application ( int& argc, char **argv )
 		else
 		if (sArg == "-g" || sArg == "--no-gui")
 			m_bGui = false;
+		else
+		if (sArg == "-p" || sArg == "--polyphony") {
+			if (++i < argc)
+				m_iPolyphony = QString::fromLocal8Bit(argv[i]).toInt();
+		}
+		else
+		if (sArg.startsWith("--polyphony="))
+			m_iPolyphony = sArg.section('=', 1).toInt();
 	}
 
 	if (m_bGui) {
@@ -795,6 +906,7 @@ drumkv1_jack_application::~drumkv1_jack_application (void)
 #ifdef HAVE_SIGNAL_H
 	if (m_pSigtermNotifier) delete m_pSigtermNotifier;
 #endif
+	if (m_pLatencyTimer) delete m_pLatencyTimer;
 #ifdef CONFIG_NSM
 	if (m_pNsmClient) delete m_pNsmClient;
 #endif
@@ -819,6 +931,7 @@ bool drumkv1_jack_application::parse_args (void)
 				DRUMKV1_TITLE " - " DRUMKV1_SUBTITLE "\n\n"
 				"Options:\n\n"
 				"  -g, --no-gui\n\tDisable the graphical user interface (GUI)\n\n"
+				"  -p, --polyphony=[voices]\n\tSet the maximum number of playing voices\n\n"
 				"  -h, --help\n\tShow help about command line options\n\n"
 				"  -v, --version\n\tShow version information\n\n")
 				.arg(args.at(0));
@@ -854,7 +967,14 @@ bool drumkv1_jack_application::setup (void)
 		SIGNAL(shutdown_signal()),
 		SLOT(shutdown_slot()));
 
-	m_pDrumk = new drumkv1_jack();
+	m_pDrumk = new drumkv1_jack(m_iPolyphony > 0 ? m_iPolyphony : 0);
+
+	// JACK latency change poll (eg. limiter toggled).
+	m_pLatencyTimer = new QTimer(this);
+	QObject::connect(m_pLatencyTimer,
+		SIGNAL(timeout()),
+		SLOT(latency_slot()));
+	m_pLatencyTimer->start(200);
 
 	if (m_bGui) {
 		m_pWidget = new drumkv1widget_jack(m_pDrumk);
@@ -1064,6 +1184,14 @@ void drumkv1_jack_application::shutdown_slot (void)
 }
 
 
+// JACK latency change poll.
+void drumkv1_jack_application::latency_slot (void)
+{
+	if (m_pDrumk)
+		m_pDrumk->updateLatency();
+}
+
+
 // Pseudo-singleton instance.
 drumkv1_jack_application *drumkv1_jack_application::g_pInstance = nullptr;
 
@@ -43,7 +43,7 @@ class drumkv1_jack : public drumkv1
 {
 public:
 
-	drumkv1_jack();
+	drumkv1_jack(int nvoices = 0);
 
 	~drumkv1_jack();
 
@@ -57,6 +57,12 @@ public:
 
 	int process(jack_nframes_t nframes);
 
+	// JACK latency (pipelined effects) handler.
+	void latencyEvent(jack_latency_callback_mode_t mode);
+
+	// JACK latency change check (non-RT).
+	void updateLatency();
+
 #ifdef CONFIG_ALSA_MIDI
 	snd_seq_t *alsa_seq() const;
 	void alsa_capture(snd_seq_event_t *ev);
@@ -84,6 +90,11 @@ protected:
 
 	void updateTuning();
 
+	// timestamped MIDI event queue (sample-accurate processing)
+	void process_event(float **ins, float **outs,
+		uint32_t time, uint8_t *data, uint32_t size, bool copy = false);
+	void process_events(float **ins, float **outs, uint32_t time);
+
 private:
 
 	jack_client_t *m_client;
@@ -98,6 +109,19 @@ private:
 
 	float m_params[drumkv1::NUM_PARAMS];
 
+	uint32_t m_latency;
+
+	static const uint32_t MAX_EVENTS = 1024;
+	static const uint32_t MAX_EVENT_BUFFER = 4096;
+
+	drumkv1::MidiEvent m_events[MAX_EVENTS];
+	uint32_t m_nevents;
+	uint32_t m_noffset;
+	uint32_t m_ntime;
+
+	uint8_t  m_event_buffer[MAX_EVENT_BUFFER];
+	uint32_t m_nbuffer;
+
 #ifdef CONFIG_JACK_MIDI
 	jack_port_t *m_midi_in;
 #endif
@@ -132,6 +156,8 @@ class drumkv1_nsm;
 class QSocketNotifier;
 #endif
 
+class QTimer;
+
 class drumkv1_jack_application : public QObject
 {
 	Q_OBJECT
@@ -174,6 +200,9 @@ protected slots:
 
 	void shutdown_slot();
 
+	// JACK latency change poll.
+	void latency_slot();
+
 protected:
 
 	// Argument parser method.
@@ -187,12 +216,15 @@ private:
 	// Instance variables.
 	QCoreApplication *m_pApp;
 	bool m_bGui;
+	int m_iPolyphony;
 
 	QStringList m_presets;
 
 	drumkv1_jack *m_pDrumk;
 	drumkv1widget_jack *m_pWidget;
 
+	QTimer *m_pLatencyTimer;
+
 #ifdef CONFIG_NSM
 	drumkv1_nsm *m_pNsmClient;
 #endif
@@ -149,9 +149,14 @@ drumkv1_lv2::drumkv1_lv2 (
 	m_urid_map = nullptr;
 	m_atom_in  = nullptr;
 	m_atom_out = nullptr;
+
+	m_latency = nullptr;
 	m_schedule = nullptr;
 	m_ndelta   = 0;
 
+	m_nevents  = 0;
+	m_noffset  = 0;
+
 	const LV2_Options_Option *host_options = nullptr;
 
 	for (int i = 0; host_features && host_features[i]; ++i) {
@@ -221,6 +226,8 @@ drumkv1_lv2::drumkv1_lv2 (
 				m_urids.bufsz_nominalBlockLength = m_urid_map->map(
 					m_urid_map->handle, LV2_BUF_SIZE__nominalBlockLength);
 			#endif
+				m_urids.polyphony = m_urid_map->map(
+					m_urid_map->handle, DRUMKV1_LV2_PREFIX "POLYPHONY");
 				m_urids.state_StateChanged = m_urid_map->map(
 					m_urid_map->handle, LV2_STATE__StateChanged);
 			#ifdef CONFIG_LV2_PATCH
@@ -244,6 +251,8 @@ drumkv1_lv2::drumkv1_lv2 (
 	}
 
 	uint32_t buffer_size = 0; // whatever happened to safe default?
+	uint32_t nominal_size = 0;
+	int polyphony = 0;
 
 	for (int i = 0; host_options && host_options[i].key; ++i) {
 		const LV2_Options_Option *host_option = &host_options[i];
@@ -257,8 +266,11 @@ drumkv1_lv2::drumkv1_lv2 (
 		#ifdef LV2_BUF_SIZE__nominalBlockLength
 			else
 			if (host_option->key == m_urids.bufsz_nominalBlockLength)
-				block_length = *(int *) host_option->value;
+				block_length = nominal_size = *(int *) host_option->value;
 		#endif
+			else
+			if (host_option->key == m_urids.polyphony)
+				polyphony = *(int *) host_option->value;
 			// choose the lengthier...
 			if (buffer_size < block_length)
 				buffer_size = block_length;
@@ -267,6 +279,13 @@ drumkv1_lv2::drumkv1_lv2 (
 
 	drumkv1::setBufferSize(buffer_size);
 
+	// pipelined effects latency (one nominal block)...
+	if (nominal_size > 0)
+		drumkv1::setNominalBufferSize(nominal_size);
+
+	if (polyphony > 0)
+		drumkv1::setPolyphony(polyphony);
+
 	lv2_atom_forge_init(&m_forge, m_urid_map);
 
 	const uint16_t nchannels = drumkv1::channels();
@@ -305,6 +324,9 @@ void drumkv1_lv2::connect_port ( uint32_t port, void *data )
 	case AudioOutR:
 		m_outs[1] = (float *) data;
 		break;
+	case Latency:
+		m_latency = (float *) data;
+		break;
 	default:
 		drumkv1::setParamPort(drumkv1::ParamIndex(port - ParamBase), (float *) data);
 		break;
@@ -321,6 +343,9 @@ void drumkv1_lv2::run ( uint32_t nframes )
 		outs[k] = m_outs[k];
 	}
 
+	if (m_latency)
+		*m_latency = float(drumkv1::latency());
+
 	if (m_atom_out) {
 		const uint32_t capacity = m_atom_out->atom.size;
 		lv2_atom_forge_set_buffer(&m_forge, (uint8_t *) m_atom_out, capacity);
@@ -329,24 +354,18 @@ void drumkv1_lv2::run ( uint32_t nframes )
 
 	uint32_t ndelta = 0;
 
+	m_nevents = 0;
+	m_noffset = 0;
+
 	if (m_atom_in) {
 		LV2_ATOM_SEQUENCE_FOREACH(m_atom_in, event) {
 			if (event == nullptr)
 				continue;
 			if (event->body.type == m_urids.midi_MidiEvent) {
 				uint8_t *data = (uint8_t *) LV2_ATOM_BODY(&event->body);
-				if (event->time.frames > ndelta) {
-					const uint32_t nread = event->time.frames - ndelta;
-					if (nread > 0) {
-						drumkv1::process(ins, outs, nread);
-						for (uint16_t k = 0; k < nchannels; ++k) {
-							ins[k]  += nread;
-							outs[k] += nread;
-						}
-					}
-				}
-				ndelta = event->time.frames;
-				drumkv1::process_midi(data, event->body.size);
+				if (event->time.frames > ndelta)
+					ndelta = event->time.frames;
+				process_event(ins, outs, ndelta, data, event->body.size);
 			}
 			else
 			if (event->body.type == m_urids.atom_Blank ||
@@ -482,14 +501,49 @@ void drumkv1_lv2::run ( uint32_t nframes )
 	//	m_atom_in = nullptr;
 	}
 
-	if (nframes > ndelta)
-		drumkv1::process(ins, outs, nframes - ndelta);
+	// process the whole (remaining) block at once...
+	process_events(ins, outs, nframes);
 
 	// test for current element-key/sample changes
 	drumkv1::currentElementTest();
 }
 
 
+// timestamped MIDI event queue (sample-accurate processing)
+void drumkv1_lv2::process_event ( float **ins, float **outs,
+	uint32_t time, uint8_t *data, uint32_t size )
+{
+	// event queue full? flush up to now...
+	if (m_nevents >= MAX_EVENTS)
+		process_events(ins, outs, time);
+
+	drumkv1::MidiEvent& event = m_events[m_nevents++];
+	event.time = time - m_noffset;
+	event.data = data;
+	event.size = size;
+}
+
+
+void drumkv1_lv2::process_events ( float **ins, float **outs, uint32_t time )
+{
+	if (time < m_noffset)
+		time = m_noffset;
+
+	const uint32_t nread = time - m_noffset;
+	if (nread > 0 || m_nevents > 0) {
+		drumkv1::process(ins, outs, nread, m_events, m_nevents);
+		const uint16_t nchannels = drumkv1::channels();
+		for (uint16_t k = 0; k < nchannels; ++k) {
+			ins[k]  += nread;
+			outs[k] += nread;
+		}
+	}
+
+	m_noffset = time;
+	m_nevents = 0;
+}
+
+
 void drumkv1_lv2::activate (void)
 {
 	drumkv1::reset();
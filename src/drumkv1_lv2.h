@@ -63,7 +63,8 @@ public:
 		AudioInR,
 		AudioOutL,
 		AudioOutR,
-		ParamBase
+		ParamBase,
+		Latency = ParamBase + drumkv1::NUM_PARAMS
 	};
 
 	void connect_port(uint32_t port, void *data);
@@ -152,6 +153,7 @@ private:
 		LV2_URID bufsz_minBlockLength;
 		LV2_URID bufsz_maxBlockLength;
 		LV2_URID bufsz_nominalBlockLength;
+		LV2_URID polyphony;
 		LV2_URID state_StateChanged;
 	#ifdef CONFIG_LV2_PATCH
 		LV2_URID patch_Get;
@@ -168,12 +170,25 @@ private:
 
 	uint32_t m_ndelta;
 
+	// timestamped MIDI event queue (sample-accurate processing)
+	void process_event(float **ins, float **outs,
+		uint32_t time, uint8_t *data, uint32_t size);
+	void process_events(float **ins, float **outs, uint32_t time);
+
+	static const uint32_t MAX_EVENTS = 1024;
+
+	drumkv1::MidiEvent m_events[MAX_EVENTS];
+	uint32_t m_nevents;
+	uint32_t m_noffset;
+
 	LV2_Atom_Sequence *m_atom_in;
 	LV2_Atom_Sequence *m_atom_out;
 
 	float **m_ins;
 	float **m_outs;
 
+	float *m_latency;
+
 #ifdef CONFIG_LV2_PROGRAMS
 	LV2_Program_Descriptor m_program;
 	QByteArray m_aProgramName;
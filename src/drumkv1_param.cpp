@@ -22,7 +22,14 @@
 #include "drumkv1_param.h"
 #include "drumkv1_config.h"
 
+#include "drumkv1_sample.h"
+
 #include <QHash>
+#include <QList>
+#include <QSet>
+
+#include <QThreadPool>
+#include <QRunnable>
 
 #include <QDomDocument>
 #include <QTextStream>
@@ -214,6 +221,32 @@ bool drumkv1_param::paramFloat ( drumkv1::ParamIndex index )
 
 
 
+// Concurrent sample decoding (prefetch into the shared sample pool).
+class drumkv1_param_prefetch : public QRunnable
+{
+public:
+
+	drumkv1_param_prefetch(const QByteArray& aSampleFile, float srate)
+		: m_aSampleFile(aSampleFile), m_srate(srate), m_data(nullptr)
+		{ QRunnable::setAutoDelete(false); }
+
+	~drumkv1_param_prefetch()
+		{ drumkv1_sample_pool::release(m_data); }
+
+	void run()
+	{
+		m_data = drumkv1_sample_pool::acquire(
+			m_aSampleFile.constData(), m_srate, true);
+	}
+
+private:
+
+	QByteArray m_aSampleFile;
+	float m_srate;
+	drumkv1_sample_data *m_data;
+};
+
+
 // Element serialization methods.
 void drumkv1_param::loadElements (
 	drumkv1 *pDrumk, const QDomElement& eElements,
@@ -230,6 +263,34 @@ void drumkv1_param::loadElements (
 			s_hash.insert(drumkv1_params[i].name, drumkv1::ParamIndex(i));
 	}
 
+	// decode all element samples concurrently first,
+	// just once for each distinct file (multi-key kits)...
+	QList<drumkv1_param_prefetch *> prefetches;
+	QSet<QByteArray> prefetch_files;
+	QThreadPool prefetch_pool;
+	const float srate = pDrumk->sampleRate();
+	for (QDomNode nElement = eElements.firstChild();
+			!nElement.isNull();
+				nElement = nElement.nextSibling()) {
+		const QDomElement& eElement = nElement.toElement();
+		if (eElement.isNull() || eElement.tagName() != "element")
+			continue;
+		const QDomElement& eSample = eElement.firstChildElement("sample");
+		if (eSample.isNull())
+			continue;
+		const QByteArray aSampleFile
+			= mapPath.absolutePath(
+				drumkv1_param::loadFilename(eSample.text())).toUtf8();
+		if (prefetch_files.contains(aSampleFile))
+			continue;
+		prefetch_files.insert(aSampleFile);
+		drumkv1_param_prefetch *prefetch
+			= new drumkv1_param_prefetch(aSampleFile, srate);
+		prefetches.append(prefetch);
+		prefetch_pool.start(prefetch);
+	}
+	prefetch_pool.waitForDone();
+
 	for (QDomNode nElement = eElements.firstChild();
 			!nElement.isNull();
 				nElement = nElement.nextSibling()) {
@@ -264,6 +325,10 @@ void drumkv1_param::loadElements (
 							drumkv1_param::loadFilename(sSampleFile)).toUtf8();
 					element->setSampleFile(aSampleFile.constData());
 					element->setOffsetRange(iOffsetStart, iOffsetEnd);
+					if (eChild.hasAttribute("silence-threshold")) {
+						element->setSilenceThreshold(
+							eChild.attribute("silence-threshold").toFloat());
+					}
 				}
 				else
 				if (eChild.tagName() == "params") {
@@ -290,6 +355,9 @@ void drumkv1_param::loadElements (
 			}
 		}
 	}
+
+	// all samples are now shared by the elements themselves.
+	qDeleteAll(prefetches);
 }
 
 
@@ -315,6 +383,7 @@ void drumkv1_param::saveElements (
 		eSample.setAttribute("name", "GEN1_SAMPLE");
 		eSample.setAttribute("offset-start", element->offsetStart());
 		eSample.setAttribute("offset-end", element->offsetEnd());
+		eSample.setAttribute("silence-threshold", element->silenceThreshold());
 		eSample.appendChild(doc.createTextNode(mapPath.abstractPath(
 			drumkv1_param::saveFilename(
 				QString::fromUtf8(pszSampleFile), bSymLink))));
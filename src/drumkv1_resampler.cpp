@@ -22,6 +22,8 @@
 
 #include "drumkv1_resampler.h"
 
+#include "drumkv1_simd.h"
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -57,7 +59,8 @@ drumkv1_resampler::Mutex  drumkv1_resampler::Table::g_mutex;
 
 drumkv1_resampler::Table::Table (
 	float fr0, unsigned int hl0, unsigned int np0 )
-	: next(nullptr), refc(0), ctab(nullptr), fr(fr0), hl(hl0), np(np0)
+	: next(nullptr), refc(0), ctab(nullptr), rtab(nullptr),
+		fr(fr0), hl(hl0), np(np0)
 {
 	unsigned int i, j;
 	float t;
@@ -73,11 +76,21 @@ drumkv1_resampler::Table::Table (
 		}
 		ptab += hl;
 	}
+
+	// same rows, in ascending order (single channel dot product).
+	rtab = new float [hl * (np + 1)];
+	ptab = rtab;
+	for (j = 0; j <= np; ++j) {
+		for (i = 0; i < hl; ++i)
+			ptab[i] = ctab[hl * j + hl - i - 1];
+		ptab += hl;
+	}
 }
 
 
 drumkv1_resampler::Table::~Table (void)
 {
+	delete [] rtab;
 	delete [] ctab;
 }
 
@@ -333,6 +346,14 @@ bool drumkv1_resampler::process (void)
 			inp_count--;
 		} else {
 			if (out_data) {
+				if (nz < 2 * hl && m_nchan == 1) {
+					const float *c1 = m_table->ctab + hl * ph;
+					const float *c2 = m_table->rtab + hl * (np - ph);
+					const float s = 1e-20f
+						+ drumkv1_simd_dot2(p1, c1, p2 - hl, c2, hl);
+					*out_data++ = s - 1e-20f;
+				}
+				else
 				if (nz < 2 * hl) {
 					float *c1 = m_table->ctab + hl * ph;
 					float *c2 = m_table->ctab + hl * (np - ph);
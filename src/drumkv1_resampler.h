@@ -79,6 +79,7 @@ public:
 		Table        *next;
 		unsigned int  refc;
 		float        *ctab;
+		float        *rtab;
 		float         fr;
 		unsigned int  hl;
 		unsigned int  np;
@@ -22,6 +22,9 @@
 #ifndef __drumkv1_reverb_h
 #define __drumkv1_reverb_h
 
+#include "drumkv1_simd.h"
+#include "drumkv1_fx.h"
+
 #include <stdint.h>
 #include <string.h>
 
@@ -32,6 +35,10 @@
 // -- borrowed, stirred and refactored from original FreeVerb --
 //    by Jezar at Dreampoint, June 2000 (public domain)
 //
+// -- processed in blocks no longer than the shortest delay line:
+//    all comb filters (both channels) are damped in 4-wide lanes,
+//    all delay lines are read/written as contiguous frames.
+//
 
 class drumkv1_reverb
 {
@@ -71,11 +78,42 @@ public:
 			m_comb1[j].reset();
 		}
 
+		// max. block length (shortest delay line)
+		// and tail period (longest comb and all-passes)...
+		m_nblock = MAX_BLOCK;
+		m_ntail = 0;
+
+		for (j = 0; j < NUM_ALLPASSES; ++j) {
+			if (m_nblock > m_allpass0[j].size())
+				m_nblock = m_allpass0[j].size();
+			if (m_nblock > m_allpass1[j].size())
+				m_nblock = m_allpass1[j].size();
+			m_ntail += m_allpass1[j].size();
+		}
+
+		uint32_t ncomb = 0;
+
+		for (j = 0; j < NUM_COMBS; ++j) {
+			if (m_nblock > m_comb0[j].size())
+				m_nblock = m_comb0[j].size();
+			if (m_nblock > m_comb1[j].size())
+				m_nblock = m_comb1[j].size();
+			if (ncomb < m_comb1[j].size())
+				ncomb = m_comb1[j].size();
+		}
+
+		m_ntail += ncomb;
+
+		m_tail.reset();
+
 		reset_feedb();
 		reset_room();
 		reset_damp();
 	}
 
+	bool active(float peak, uint32_t nframes, float room)
+		{ return m_tail.process(peak, nframes, float(m_ntail), room); }
+
 	void process(float *in0, float *in1, uint32_t nframes,
 		float wet, float feedb, float room, float damp, float width)
 	{
@@ -97,36 +135,80 @@ public:
 			reset_damp();
 		}
 
-		uint32_t i, j;
+		float x0[MAX_BLOCK], x1[MAX_BLOCK];
+		float t0[MAX_BLOCK], t1[MAX_BLOCK];
+
+		float ys[NUM_LANES][MAX_BLOCK];
+		float *yp[NUM_LANES];
+		float ss[NUM_LANES];
+		float ds[NUM_LANES];
+
+		uint32_t n, j;
 
-		for (i = 0; i < nframes; ++i) {
+		for (uint32_t i = 0; i < nframes; i += n) {
 
-			float out0 = *in0 * 0.05f; // 0.015f;
-			float out1 = *in1 * 0.05f; // 0.015f;
+			n = nframes - i;
+			if (n > m_nblock)
+				n = m_nblock;
+
+			for (j = 0; j < n; ++j) {
+				x0[j] = in0[j] * 0.05f; // 0.015f;
+				x1[j] = in1[j] * 0.05f; // 0.015f;
+				t0[j] = 0.0f;
+				t1[j] = 0.0f;
+			}
+
+			// comb filters: delayed outputs (summed)...
+			for (j = 0; j < NUM_COMBS; ++j) {
+				comb_filter& comb0 = m_comb0[j];
+				comb_filter& comb1 = m_comb1[j];
+				float *y0 = ys[j];
+				float *y1 = ys[NUM_COMBS + j];
+				comb0.read(y0, n);
+				comb1.read(y1, n);
+				drumkv1_simd_add(t0, y0, n);
+				drumkv1_simd_add(t1, y1, n);
+				yp[j] = y0;
+				yp[NUM_COMBS + j] = y1;
+				ss[j] = comb0.out();
+				ss[NUM_COMBS + j] = comb1.out();
+				ds[j] = comb0.damp();
+				ds[NUM_COMBS + j] = comb1.damp();
+			}
 
-			float tmp0 = 0.0f;
-			float tmp1 = 0.0f;
+			// comb filters: damping (lanes)...
+			drumkv1_simd_lpf(yp, ss, ds, NUM_LANES, n);
 
+			// comb filters: feedback...
 			for (j = 0; j < NUM_COMBS; ++j) {
-				tmp0 += m_comb0[j].output(out0);
-				tmp1 += m_comb1[j].output(out1);
+				comb_filter& comb0 = m_comb0[j];
+				comb_filter& comb1 = m_comb1[j];
+				comb0.write(x0, ys[j], n);
+				comb1.write(x1, ys[NUM_COMBS + j], n);
+				comb0.set_out(ss[j]);
+				comb1.set_out(ss[NUM_COMBS + j]);
 			}
 
 			for (j = 0; j < NUM_ALLPASSES; ++j) {
-				tmp0 = m_allpass0[j].output(tmp0);
-				tmp1 = m_allpass1[j].output(tmp1);
+				m_allpass0[j].process(t0, n);
+				m_allpass1[j].process(t1, n);
 			}
 
-			if (width < 0.0f) {
-				out0 = tmp0 * (1.0f + width) - tmp1 * width;
-				out1 = tmp1 * (1.0f + width) - tmp0 * width;
-			} else {
-				out0 = tmp0 * width + tmp1 * (1.0f - width);
-				out1 = tmp1 * width + tmp0 * (1.0f - width);
+			for (j = 0; j < n; ++j) {
+				float out0, out1;
+				if (width < 0.0f) {
+					out0 = t0[j] * (1.0f + width) - t1[j] * width;
+					out1 = t1[j] * (1.0f + width) - t0[j] * width;
+				} else {
+					out0 = t0[j] * width + t1[j] * (1.0f - width);
+					out1 = t1[j] * width + t0[j] * (1.0f - width);
+				}
+				in0[j] += wet * out0;
+				in1[j] += wet * out1;
 			}
 
-			*in0++ += wet * out0;
-			*in1++ += wet * out1;
+			in0 += n;
+			in1 += n;
 		}
 	}
 
@@ -136,6 +218,9 @@ protected:
 	static const uint32_t NUM_ALLPASSES = 6;
 	static const uint32_t STEREO_SPREAD = 23;
 
+	static const uint32_t MAX_BLOCK = 64;
+	static const uint32_t NUM_LANES = 2 * NUM_COMBS;
+
 	void reset_room()
 	{
 		for (uint32_t j = 0; j < NUM_COMBS; ++j) {
@@ -195,12 +280,28 @@ protected:
 			}
 		}
 
-		float *tick()
+		uint32_t size() const
+			{ return m_size; }
+
+	protected:
+
+		// contiguous frames at current index (up to buffer end).
+		float *frames(uint32_t& nframes) const
+		{
+			const uint32_t nremain = m_size - m_index;
+			if (nframes > nremain)
+				nframes = nremain;
+			return m_buffer + m_index;
+		}
+
+		float *buffer() const
+			{ return m_buffer; }
+
+		void advance(uint32_t nframes)
 		{
-			float *buf = m_buffer + m_index;
-			if (++m_index >= m_size)
-				m_index = 0;
-			return buf;
+			m_index += nframes;
+			if (m_index >= m_size)
+				m_index -= m_size;
 		}
 
 	private:
@@ -227,16 +328,35 @@ protected:
 		float damp() const
 			{ return m_damp; }
 
+		void set_out(float out)
+			{ m_out = out; }
+		float out() const
+			{ return m_out; }
+
 		void reset()
 			{ sample_buffer::reset(); m_out = 0.0f; }
 
-		float output(float in)
+		// delayed (undamped) outputs.
+		void read(float *y, uint32_t nframes) const
 		{
-			float *buf = tick();
-			float  out = *buf;
-			m_out = denormal(out * (1.0f - m_damp) + m_out * m_damp);
-			*buf = in + (m_out * m_feedb);
-			return out;
+			uint32_t n1 = nframes;
+			const float *buf = frames(n1);
+			::memcpy(y, buf, n1 * sizeof(float));
+			if (n1 < nframes)
+				::memcpy(y + n1, buffer(), (nframes - n1) * sizeof(float));
+		}
+
+		// feedback (damped outputs) and advance.
+		void write(const float *x, const float *z, uint32_t nframes)
+		{
+			uint32_t n1 = nframes;
+			float *buf = frames(n1);
+			drumkv1_simd_comb(buf, x, z, m_feedb, n1);
+			if (n1 < nframes) {
+				drumkv1_simd_comb(buffer(),
+					x + n1, z + n1, m_feedb, nframes - n1);
+			}
+			advance(nframes);
 		}
 
 	private:
@@ -258,12 +378,17 @@ protected:
 		float feedb () const
 			{ return m_feedb; }
 
-		float output(float in)
+		// in-place and advance.
+		void process(float *x, uint32_t nframes)
 		{
-			float *buf = tick();
-			float  out = *buf;
-			*buf = denormal(in + out * m_feedb);
-			return out - in;
+			uint32_t n1 = nframes;
+			float *buf = frames(n1);
+			drumkv1_simd_allpass(buf, x, m_feedb, n1);
+			if (n1 < nframes) {
+				drumkv1_simd_allpass(buffer(),
+					x + n1, m_feedb, nframes - n1);
+			}
+			advance(nframes);
 		}
 
 	private:
@@ -271,13 +396,6 @@ protected:
 		float m_feedb;
 	};
 
-	static float denormal(float v)
-	{
-		union { float f; uint32_t w; } u;
-		u.f = v;
-		return (u.w & 0x7f800000) ? v : 0.0f;
-	}
-
 private:
 
 	float m_srate;
@@ -286,6 +404,11 @@ private:
 	float m_damp;
 	float m_feedb;
 
+	uint32_t m_nblock;
+	uint32_t m_ntail;
+
+	drumkv1_fx_tail m_tail;
+
 	comb_filter m_comb0[NUM_COMBS];
 	comb_filter m_comb1[NUM_COMBS];
 
@@ -0,0 +1,352 @@
+// drumkv1_rtcheck.cpp
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "drumkv1_rtcheck.h"
+
+#ifdef CONFIG_RTCHECK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <poll.h>
+#include <time.h>
+
+#include <sys/select.h>
+#include <sys/syscall.h>
+
+#include <linux/futex.h>
+
+#include <atomic>
+
+
+//-------------------------------------------------------------------------
+// drumkv1_rtcheck - real-time safety checker (debug builds only).
+//
+
+// per-thread state (initial-exec: no allocation on first access).
+#define DRUMKV1_RTCHECK_TLS \
+	static __thread __attribute__((tls_model("initial-exec")))
+
+DRUMKV1_RTCHECK_TLS int g_rtcheck_depth = 0;
+DRUMKV1_RTCHECK_TLS int g_rtcheck_suspend = 0;
+DRUMKV1_RTCHECK_TLS const char *g_rtcheck_name = nullptr;
+
+static std::atomic<uint32_t> g_rtcheck_violations(0);
+static std::atomic<int> g_rtcheck_abort(-1);
+
+// max. violations reported in full (all are counted anyway).
+static const uint32_t MAX_REPORTS = 32;
+
+
+// real-time section enter/leave (current thread).
+void drumkv1_rtcheck::enter ( const char *name )
+{
+	if (++g_rtcheck_depth == 1)
+		g_rtcheck_name = name;
+}
+
+
+void drumkv1_rtcheck::leave (void)
+{
+	if (--g_rtcheck_depth == 0)
+		g_rtcheck_name = nullptr;
+}
+
+
+// suspend/resume checking (current thread).
+void drumkv1_rtcheck::suspend ( bool on )
+{
+	if (on)
+		++g_rtcheck_suspend;
+	else
+		--g_rtcheck_suspend;
+}
+
+
+// whether current thread is being checked.
+bool drumkv1_rtcheck::isActive (void)
+{
+	return (g_rtcheck_depth > 0 && g_rtcheck_suspend == 0);
+}
+
+
+// report a violation (offending call name).
+void drumkv1_rtcheck::violation ( const char *what )
+{
+	// no checking while reporting...
+	suspend(true);
+
+	const uint32_t n = ++g_rtcheck_violations;
+	if (n <= MAX_REPORTS) {
+		::fprintf(stderr, "drumkv1_rtcheck: %s() called from %s"
+			" (real-time violation #%u)\n", what, g_rtcheck_name, n);
+		void *frames[32];
+		const int nframes = ::backtrace(frames, 32);
+		::backtrace_symbols_fd(frames, nframes, STDERR_FILENO);
+		if (n == MAX_REPORTS)
+			::fprintf(stderr, "drumkv1_rtcheck: further violations"
+				" will be counted only.\n");
+	}
+
+	if (isAbort())
+		::abort();
+
+	suspend(false);
+}
+
+
+// violations count (eg. for headless test harnesses).
+uint32_t drumkv1_rtcheck::violations (void)
+{
+	return g_rtcheck_violations;
+}
+
+
+void drumkv1_rtcheck::resetViolations (void)
+{
+	g_rtcheck_violations = 0;
+}
+
+
+// abort on violation.
+void drumkv1_rtcheck::setAbort ( bool on )
+{
+	g_rtcheck_abort = (on ? 1 : 0);
+}
+
+
+bool drumkv1_rtcheck::isAbort (void)
+{
+	int ret = g_rtcheck_abort;
+	if (ret < 0) {
+		const char *env = ::getenv("DRUMKV1_RTCHECK");
+		ret = (env && ::strcmp(env, "abort") == 0 ? 1 : 0);
+		g_rtcheck_abort = ret;
+	}
+	return (ret > 0);
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_rtcheck - interposed (non real-time safe) calls.
+//
+
+#define DRUMKV1_RTCHECK_CALL(what) \
+	if (drumkv1_rtcheck::isActive()) drumkv1_rtcheck::violation(what)
+
+#define DRUMKV1_RTCHECK_NEXT(func) \
+	static decltype(&::func) next_##func \
+		= reinterpret_cast<decltype(&::func)> (::dlsym(RTLD_NEXT, #func))
+
+
+extern "C" {
+
+// glibc allocator entry points (no dlsym bootstrapping needed).
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void *__libc_memalign(size_t, size_t);
+extern void  __libc_free(void *);
+
+
+void *malloc ( size_t size ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("malloc");
+	return __libc_malloc(size);
+}
+
+
+void *calloc ( size_t nmemb, size_t size ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("calloc");
+	return __libc_calloc(nmemb, size);
+}
+
+
+void *realloc ( void *ptr, size_t size ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("realloc");
+	return __libc_realloc(ptr, size);
+}
+
+
+void *memalign ( size_t alignment, size_t size ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("memalign");
+	return __libc_memalign(alignment, size);
+}
+
+
+void *aligned_alloc ( size_t alignment, size_t size ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("aligned_alloc");
+	return __libc_memalign(alignment, size);
+}
+
+
+int posix_memalign ( void **ptr, size_t alignment, size_t size ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("posix_memalign");
+	*ptr = __libc_memalign(alignment, size);
+	return (*ptr ? 0 : 12 /*ENOMEM*/);
+}
+
+
+void free ( void *ptr ) throw()
+{
+	if (ptr) {
+		DRUMKV1_RTCHECK_CALL("free");
+	}
+	__libc_free(ptr);
+}
+
+
+int pthread_mutex_lock ( pthread_mutex_t *mutex ) throw()
+{
+	DRUMKV1_RTCHECK_CALL("pthread_mutex_lock");
+	DRUMKV1_RTCHECK_NEXT(pthread_mutex_lock);
+	return next_pthread_mutex_lock(mutex);
+}
+
+
+int pthread_cond_wait ( pthread_cond_t *cond, pthread_mutex_t *mutex )
+{
+	DRUMKV1_RTCHECK_CALL("pthread_cond_wait");
+	DRUMKV1_RTCHECK_NEXT(pthread_cond_wait);
+	return next_pthread_cond_wait(cond, mutex);
+}
+
+
+int pthread_cond_timedwait ( pthread_cond_t *cond,
+	pthread_mutex_t *mutex, const struct timespec *abstime )
+{
+	DRUMKV1_RTCHECK_CALL("pthread_cond_timedwait");
+	DRUMKV1_RTCHECK_NEXT(pthread_cond_timedwait);
+	return next_pthread_cond_timedwait(cond, mutex, abstime);
+}
+
+
+int pthread_join ( pthread_t thread, void **retval )
+{
+	DRUMKV1_RTCHECK_CALL("pthread_join");
+	DRUMKV1_RTCHECK_NEXT(pthread_join);
+	return next_pthread_join(thread, retval);
+}
+
+
+int sem_wait ( sem_t *sem )
+{
+	DRUMKV1_RTCHECK_CALL("sem_wait");
+	DRUMKV1_RTCHECK_NEXT(sem_wait);
+	return next_sem_wait(sem);
+}
+
+
+int nanosleep ( const struct timespec *req, struct timespec *rem )
+{
+	DRUMKV1_RTCHECK_CALL("nanosleep");
+	DRUMKV1_RTCHECK_NEXT(nanosleep);
+	return next_nanosleep(req, rem);
+}
+
+
+int usleep ( useconds_t usec )
+{
+	DRUMKV1_RTCHECK_CALL("usleep");
+	DRUMKV1_RTCHECK_NEXT(usleep);
+	return next_usleep(usec);
+}
+
+
+unsigned int sleep ( unsigned int seconds )
+{
+	DRUMKV1_RTCHECK_CALL("sleep");
+	DRUMKV1_RTCHECK_NEXT(sleep);
+	return next_sleep(seconds);
+}
+
+
+ssize_t read ( int fd, void *buf, size_t count )
+{
+	DRUMKV1_RTCHECK_CALL("read");
+	DRUMKV1_RTCHECK_NEXT(read);
+	return next_read(fd, buf, count);
+}
+
+
+ssize_t write ( int fd, const void *buf, size_t count )
+{
+	DRUMKV1_RTCHECK_CALL("write");
+	DRUMKV1_RTCHECK_NEXT(write);
+	return next_write(fd, buf, count);
+}
+
+
+int poll ( struct pollfd *fds, nfds_t nfds, int timeout )
+{
+	DRUMKV1_RTCHECK_CALL("poll");
+	DRUMKV1_RTCHECK_NEXT(poll);
+	return next_poll(fds, nfds, timeout);
+}
+
+
+int select ( int nfds, fd_set *readfds, fd_set *writefds,
+	fd_set *exceptfds, struct timeval *timeout )
+{
+	DRUMKV1_RTCHECK_CALL("select");
+	DRUMKV1_RTCHECK_NEXT(select);
+	return next_select(nfds, readfds, writefds, exceptfds, timeout);
+}
+
+
+// contended QMutex/QWaitCondition et al. (Linux futex waits).
+long syscall ( long number, ... ) throw()
+{
+	va_list args;
+	va_start(args, number);
+	long a[6];
+	for (int i = 0; i < 6; ++i)
+		a[i] = va_arg(args, long);
+	va_end(args);
+
+	if (number == SYS_futex) {
+		const int op = int(a[1]) & FUTEX_CMD_MASK;
+		if (op == FUTEX_WAIT || op == FUTEX_WAIT_BITSET) {
+			DRUMKV1_RTCHECK_CALL("futex_wait");
+		}
+	}
+
+	DRUMKV1_RTCHECK_NEXT(syscall);
+	return next_syscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+}	// extern "C"
+
+
+#endif	// CONFIG_RTCHECK
+
+// end of drumkv1_rtcheck.cpp
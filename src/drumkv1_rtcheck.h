@@ -0,0 +1,102 @@
+// drumkv1_rtcheck.h
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __drumkv1_rtcheck_h
+#define __drumkv1_rtcheck_h
+
+#include "config.h"
+
+#include <stdint.h>
+
+
+#ifdef CONFIG_RTCHECK
+
+//-------------------------------------------------------------------------
+// drumkv1_rtcheck - real-time safety checker (debug builds only).
+//
+// While a thread is inside a real-time section (eg. the audio thread
+// in drumkv1::process), any call to the heap allocator (malloc/free,
+// hence new/delete), blocking mutex locks, condition waits, contended
+// futex waits, sleeps or blocking file/socket I/O is reported, with a
+// backtrace on stderr, and counted. Set DRUMKV1_RTCHECK=abort in the
+// environment to abort() on the very first violation instead.
+//
+
+class drumkv1_rtcheck
+{
+public:
+
+	// real-time section (scoped; nestable).
+	class scope
+	{
+	public:
+
+		scope(const char *name) { enter(name); }
+		~scope() { leave(); }
+	};
+
+	// known (bounded) blocking section, not to be reported (scoped).
+	class allow
+	{
+	public:
+
+		allow() { suspend(true); }
+		~allow() { suspend(false); }
+	};
+
+	// real-time section enter/leave (current thread).
+	static void enter(const char *name);
+	static void leave();
+
+	// suspend/resume checking (current thread).
+	static void suspend(bool on);
+
+	// whether current thread is being checked.
+	static bool isActive();
+
+	// report a violation (offending call name).
+	static void violation(const char *what);
+
+	// violations count (eg. for headless test harnesses).
+	static uint32_t violations();
+	static void resetViolations();
+
+	// abort on violation.
+	static void setAbort(bool on);
+	static bool isAbort();
+};
+
+#define DRUMKV1_RTCHECK_SCOPE(name) \
+	drumkv1_rtcheck::scope rtcheck_scope(name)
+#define DRUMKV1_RTCHECK_ALLOW() \
+	drumkv1_rtcheck::allow rtcheck_allow
+
+#else
+
+#define DRUMKV1_RTCHECK_SCOPE(name)
+#define DRUMKV1_RTCHECK_ALLOW()
+
+#endif	// CONFIG_RTCHECK
+
+
+#endif	// __drumkv1_rtcheck_h
+
+// end of drumkv1_rtcheck.h
@@ -21,125 +21,818 @@
 
 #include "drumkv1_sample.h"
 
+#include "drumkv1_sample_cache.h"
 #include "drumkv1_resampler.h"
 
 #include <sndfile.h>
 
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include <unistd.h>
+#include <errno.h>
+
+#include <new>
+
+#include <QMutex>
+
+#include <QThreadPool>
+#include <QRunnable>
+
 
 //-------------------------------------------------------------------------
-// drumkv1_sample - sampler wave table.
+// drumkv1_sample_data - shared decoded sample frames (immutable).
 //
 
+// page-aligned frames allocation (whole pages), so that each region
+// owns its pages: page-locks do not nest, nor should any huge-pages
+// advice ever reach unrelated (heap) memory.
+static void *drumkv1_sample_alloc ( uint64_t size )
+{
+	static const uint64_t s_page_size = uint64_t(::sysconf(_SC_PAGESIZE));
+
+	void *addr = nullptr;
+	if (::posix_memalign(&addr, s_page_size,
+			(size + s_page_size - 1) & ~(s_page_size - 1)) != 0)
+		throw std::bad_alloc();
+
+	return addr;
+}
+
+
+template <typename T>
+static T *drumkv1_sample_new ( uint32_t n )
+{
+	return static_cast<T *> (drumkv1_sample_alloc(uint64_t(n) * sizeof(T)));
+}
+
+
+static void drumkv1_sample_delete ( void *addr )
+{
+	::free(addr);
+}
+
+
 // ctor.
-drumkv1_sample::drumkv1_sample ( float srate )
-	: m_srate(srate), m_filename(nullptr), m_nchannels(0),
-		m_rate0(0.0f), m_freq0(1.0f), m_ratio(0.0f),
-		m_nframes(0), m_pframes(nullptr), m_reverse(false),
-		m_offset(false), m_offset_start(0), m_offset_end(0),
-		m_offset_phase0(0.0f), m_offset_end2(0)
+drumkv1_sample_data::drumkv1_sample_data ( const char *filename,
+	time_t mtime, float srate, Format format )
+	: filename(::strdup(filename)), mtime(mtime), srate(srate),
+		format(format), nchannels(0), rate0(0.0f), nframes(0),
+		pframes(nullptr), map_addr(nullptr), map_size(0), head_nframes(0),
+		head_pframes(nullptr), tail_pframes(nullptr), pframes16(nullptr),
+		nzeros(0), pzeros(nullptr), lock_size(0), lock_failed(false),
+		refcount(0), users(0)
 {
 }
 
 
 // dtor.
-drumkv1_sample::~drumkv1_sample (void)
+drumkv1_sample_data::~drumkv1_sample_data (void)
 {
-	close();
+	if (lock_size > 0 || lock_failed)
+		mlock(false);
+
+	if (head_pframes && head_pframes != pframes) {
+		drumkv1_sample_stream::detach_data(this);
+		for (uint16_t k = 0; k < nchannels; ++k) {
+			drumkv1_sample_delete(head_pframes[k]);
+			drumkv1_sample_delete(tail_pframes[k] - 4);
+		}
+		delete [] head_pframes;
+		delete [] tail_pframes;
+	}
+
+	if (map_addr) {
+		drumkv1_sample_cache::unmap(map_addr, map_size);
+		delete [] pframes;
+	}
+	else
+	if (pframes) {
+		for (uint16_t k = 0; k < nchannels; ++k)
+			drumkv1_sample_delete(pframes[k] - 4);
+		delete [] pframes;
+	}
+
+	if (pframes16) {
+		for (uint16_t k = 0; k < nchannels; ++k)
+			drumkv1_sample_delete(pframes16[k] - 4);
+		delete [] pframes16;
+	}
+
+	if (pzeros)
+		drumkv1_sample_delete(pzeros);
+
+	::free(filename);
 }
 
 
-// init.
-bool drumkv1_sample::open ( const char *filename, float freq0 )
+// pool key.
+bool drumkv1_sample_data::isKey ( const char *filename,
+	time_t mtime, float srate, Format format ) const
+{
+	return (this->mtime == mtime
+		&& this->srate == srate
+		&& this->format == format
+		&& ::strcmp(this->filename, filename) == 0);
+}
+
+
+// page-locked size (bytes) and failures (all sample data).
+static std::atomic<uint64_t> g_sample_lock_size(0);
+static std::atomic<uint32_t> g_sample_lock_failures(0);
+
+
+// page-lock (and prefault) or unlock a (page-aligned) memory region;
+// accounts the locked size (bytes) on success.
+static bool drumkv1_sample_mlock (
+	const void *addr, uint64_t size, bool on, uint64_t *locked )
+{
+	if (addr == nullptr || size < 1)
+		return true;
+
+	if (!on)
+		return (::munlock(addr, size) == 0);
+
+#ifdef MADV_HUGEPAGE
+	// transparent huge-pages backing, where available...
+	const uint64_t HUGE_PAGE = (2 << 20);
+	const uintptr_t addr0 = reinterpret_cast<uintptr_t> (addr);
+	const uintptr_t addr1 = (addr0 + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+	const uintptr_t addr2 = (addr0 + size) & ~(HUGE_PAGE - 1);
+	if (addr2 > addr1)
+		::madvise(reinterpret_cast<void *> (addr1), addr2 - addr1, MADV_HUGEPAGE);
+#endif
+
+	const bool ret = (::mlock(addr, size) == 0);
+	if (ret)
+		*locked += size;
+
+	// prefault anyway (lock might have failed)...
+	const volatile char *p = static_cast<const volatile char *> (addr);
+	for (uint64_t i = 0; i < size; i += 4096)
+		(void) p[i];
+	(void) p[size - 1];
+
+	return ret;
+}
+
+
+// page-lock (and prefault) or unlock all resident frames.
+bool drumkv1_sample_data::mlock ( bool on )
+{
+	uint64_t size = 0;
+	bool ret = true;
+
+	const uint32_t nsize = nframes + 8;
+	for (uint16_t k = 0; k < nchannels; ++k) {
+		if (pframes16) {
+			// compact frames...
+			ret = drumkv1_sample_mlock(pframes16[k] - 4,
+				nsize * sizeof(uint16_t), on, &size) && ret;
+		}
+		else
+		if (head_pframes && head_pframes != pframes) {
+			// streamed head and tail frames...
+			const uint32_t nhead = head_nframes + 4;
+			ret = drumkv1_sample_mlock(head_pframes[k],
+				nhead * sizeof(float), on, &size) && ret;
+			ret = drumkv1_sample_mlock(tail_pframes[k] - 4,
+				(nhead + 4) * sizeof(float), on, &size) && ret;
+		}
+		else
+		if (pframes && map_addr == nullptr) {
+			// decoded frames...
+			ret = drumkv1_sample_mlock(pframes[k] - 4,
+				nsize * sizeof(float), on, &size) && ret;
+		}
+	}
+
+	if (pzeros) {
+		ret = drumkv1_sample_mlock(pzeros,
+			nzeros * sizeof(uint32_t), on, &size) && ret;
+	}
+
+	if (on) {
+		// whatever got locked, even on partial failure...
+		lock_failed = !ret;
+		lock_size = size;
+		g_sample_lock_size += lock_size;
+		if (lock_failed)
+			++g_sample_lock_failures;
+	} else {
+		g_sample_lock_size -= lock_size;
+		if (lock_failed)
+			--g_sample_lock_failures;
+		lock_size = 0;
+		lock_failed = false;
+	}
+
+	return ret;
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_resample - single channel resampling task (decode).
+//
+
+class drumkv1_sample_resample : public QRunnable
+{
+public:
+
+	drumkv1_sample_resample(float *frames, uint32_t nout)
+		: m_frames(frames), m_nout(nout), m_count(0),
+			m_inp(nullptr), m_ninp(0)
+		{ QRunnable::setAutoDelete(false); }
+
+	bool setup(uint32_t rinp, uint32_t rout, uint32_t hlen)
+		{ return m_resampler.setup(rinp, rout, 1, hlen); }
+
+	// next input chunk.
+	void feed(const float *inp, uint32_t ninp)
+		{ m_inp = inp; m_ninp = ninp; }
+
+	void run()
+	{
+		m_resampler.inp_count = m_ninp;
+		m_resampler.inp_data  = const_cast<float *> (m_inp);
+		m_resampler.out_count = m_nout - m_count;
+		m_resampler.out_data  = m_frames + m_count;
+		m_resampler.process();
+
+		m_count = m_nout - m_resampler.out_count;
+	}
+
+	// resampled frames count (so far).
+	uint32_t count() const
+		{ return m_count; }
+
+private:
+
+	drumkv1_resampler m_resampler;
+
+	float   *m_frames;
+	uint32_t m_nout;
+	uint32_t m_count;
+
+	const float *m_inp;
+	uint32_t m_ninp;
+};
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_pool - process-wide shared sample data pool.
+//
+
+static QMutex g_sample_pool_mutex;
+
+static drumkv1_list<drumkv1_sample_data> g_sample_pool_list;
+
+static std::atomic<bool> g_sample_pool_streaming(false);
+
+static std::atomic<int> g_sample_pool_resample_quality(1);
+
+static std::atomic<int> g_sample_pool_format(drumkv1_sample_data::Float);
+
+static std::atomic<bool> g_sample_pool_locking(false);
+
+
+// acquire (decode or share) sample data.
+drumkv1_sample_data *drumkv1_sample_pool::acquire (
+	const char *filename, float srate, bool concurrent )
 {
 	if (filename == nullptr)
-		return false;
+		return nullptr;
+
+	struct stat st;
+	if (::stat(filename, &st) != 0)
+		return nullptr;
+
+	const time_t mtime = st.st_mtime;
+	const drumkv1_sample_data::Format format
+		= drumkv1_sample_data::Format(sampleFormat());
+
+	g_sample_pool_mutex.lock();
+	drumkv1_sample_data *data = lookup(filename, mtime, srate, format);
+	if (data)
+		++(data->refcount);
+	g_sample_pool_mutex.unlock();
+
+	if (data)
+		return data;
+
+	// decode outside the pool lock (concurrent loads)...
+	data = decode(filename, mtime, srate, format, concurrent);
+	if (data == nullptr)
+		return nullptr;
+
+	g_sample_pool_mutex.lock();
+	drumkv1_sample_data *data2 = lookup(filename, mtime, srate, format);
+	if (data2) {
+		// someone else got there first...
+		++(data2->refcount);
+	} else {
+		++(data->refcount);
+		g_sample_pool_list.append(data);
+	}
+	g_sample_pool_mutex.unlock();
+
+	if (data2) {
+		delete data;
+		data = data2;
+	}
+
+	return data;
+}
+
+
+// release (and free, when last) sample data.
+void drumkv1_sample_pool::release ( drumkv1_sample_data *data )
+{
+	if (data == nullptr)
+		return;
+
+	g_sample_pool_mutex.lock();
+	const bool last = (--(data->refcount) == 0);
+	if (last)
+		g_sample_pool_list.remove(data);
+	g_sample_pool_mutex.unlock();
+
+	if (last)
+		delete data;
+}
+
+
+// disk-streaming mode (long samples only).
+void drumkv1_sample_pool::setStreaming ( bool streaming )
+{
+	g_sample_pool_streaming = streaming;
+}
+
+
+bool drumkv1_sample_pool::isStreaming (void)
+{
+	return g_sample_pool_streaming;
+}
+
+
+// resident frames storage format (0=float, 1=int16, 2=half-float).
+void drumkv1_sample_pool::setSampleFormat ( int format )
+{
+	if (format < drumkv1_sample_data::Float
+		|| format > drumkv1_sample_data::Half)
+		format = drumkv1_sample_data::Float;
+
+	g_sample_pool_format = format;
+}
+
+
+int drumkv1_sample_pool::sampleFormat (void)
+{
+	return g_sample_pool_format;
+}
+
+
+// page-locked (and prefaulted) resident frames.
+void drumkv1_sample_pool::setLocking ( bool locking )
+{
+	g_sample_pool_locking = locking;
+}
 
-	close();
 
-	m_filename = ::strdup(filename);
+bool drumkv1_sample_pool::isLocking (void)
+{
+	return g_sample_pool_locking;
+}
+
+
+// page-locked size (bytes) and failures (all sample data).
+uint64_t drumkv1_sample_pool::lockedSize (void)
+{
+	return g_sample_lock_size;
+}
+
+
+uint32_t drumkv1_sample_pool::lockFailures (void)
+{
+	return g_sample_lock_failures;
+}
+
+
+// resampling quality (0=low, 1=medium, 2=high, 3=best).
+void drumkv1_sample_pool::setResampleQuality ( int quality )
+{
+	if (quality < 0)
+		quality = 0;
+	else
+	if (quality > 3)
+		quality = 3;
+
+	g_sample_pool_resample_quality = quality;
+}
+
+
+int drumkv1_sample_pool::resampleQuality (void)
+{
+	return g_sample_pool_resample_quality;
+}
+
+
+// resampling filter (half-)length, for given quality.
+uint32_t drumkv1_sample_pool::resample_filter ( int quality )
+{
+	static const uint32_t s_hlen[] = { 16, 32, 48, 96 };
+
+	return s_hlen[quality < 0 ? 0 : (quality > 3 ? 3 : quality)];
+}
+
+
+// lookup shared sample data (pool lock held).
+drumkv1_sample_data *drumkv1_sample_pool::lookup ( const char *filename,
+	time_t mtime, float srate, drumkv1_sample_data::Format format )
+{
+	drumkv1_sample_data *data = g_sample_pool_list.next();
+	while (data) {
+		if (data->isKey(filename, mtime, srate, format))
+			break;
+		data = data->next();
+	}
+	return data;
+}
+
+
+// decode sample data (not shared yet).
+drumkv1_sample_data *drumkv1_sample_pool::decode ( const char *filename,
+	time_t mtime, float srate, drumkv1_sample_data::Format format,
+	bool concurrent )
+{
+	drumkv1_sample_data *data
+		= new drumkv1_sample_data(filename, mtime, srate, format);
+
+	// already decoded and cached on disk?
+	if (drumkv1_sample_cache::load(data))
+		return lock(compact(stream(zero_crossings(data))));
 
 	SF_INFO info;
 	::memset(&info, 0, sizeof(info));
-	
-	SNDFILE *file = ::sf_open(m_filename, SFM_READ, &info);
-	if (file == nullptr)
-		return false;
 
-	m_nchannels = info.channels;
-	m_rate0     = float(info.samplerate);
-	m_nframes   = info.frames;
-
-	float *buffer = new float [m_nchannels * m_nframes];
-
-	const int nread = ::sf_readf_float(file, buffer, m_nframes);
-	if (nread > 0) {
-		// resample start...
-		const uint32_t ninp = uint32_t(nread);
-		const uint32_t rinp = uint32_t(m_rate0);
-		const uint32_t rout = uint32_t(m_srate);
-		if (rinp != rout) {
-			drumkv1_resampler resampler;
-			const uint32_t nout = uint32_t(float(ninp) * m_srate / m_rate0);
-			const uint32_t FILTSIZE = 32; // resample medium quality
-			if (resampler.setup(rinp, rout, m_nchannels, FILTSIZE)) {
-				float *inpb = buffer;
-				float *outb = new float [m_nchannels * nout];
-				resampler.inp_count = ninp;
-				resampler.inp_data  = inpb;
-				resampler.out_count = nout;
-				resampler.out_data  = outb;
-				resampler.process();
-				buffer = outb;
-				delete [] inpb;
-				// identical rates now...
-				m_rate0 = float(rout);
-				m_nframes = (nout - resampler.out_count);
+	SNDFILE *file = ::sf_open(filename, SFM_READ, &info);
+	if (file == nullptr) {
+		delete data;
+		return nullptr;
+	}
+
+	data->nchannels = info.channels;
+	data->rate0     = float(info.samplerate);
+
+	const uint16_t nchannels = data->nchannels;
+	const uint32_t ninp = uint32_t(info.frames);
+
+	const uint32_t rinp = uint32_t(data->rate0);
+	const uint32_t rout = uint32_t(srate);
+	uint32_t nout = ninp;
+
+	// final frames (4 zero frames padded on each side)...
+	data->pframes = new float * [nchannels];
+	for (uint16_t k = 0; k < nchannels; ++k)
+		data->pframes[k] = nullptr;
+
+	// resample setup (one resampler per channel)...
+	drumkv1_sample_resample **presample = nullptr;
+	if (ninp > 0 && rinp != rout) {
+		const uint32_t hlen = resample_filter(resampleQuality());
+		nout = uint32_t(float(ninp) * srate / data->rate0);
+		presample = new drumkv1_sample_resample * [nchannels];
+		for (uint16_t k = 0; k < nchannels; ++k) {
+			data->pframes[k] = drumkv1_sample_new<float> (nout + 8) + 4;
+			presample[k] = new drumkv1_sample_resample(data->pframes[k], nout);
+			if (!presample[k]->setup(rinp, rout, hlen)) {
+				for (uint16_t k2 = 0; k2 <= k; ++k2) {
+					delete presample[k2];
+					drumkv1_sample_delete(data->pframes[k2] - 4);
+					data->pframes[k2] = nullptr;
+				}
+				delete [] presample;
+				presample = nullptr;
+				nout = ninp;
+				break;
 			}
 		}
-		else m_nframes = ninp;
-		// resample end.
 	}
 
-	const uint32_t nsize = m_nframes + 4;
-	m_pframes = new float * [m_nchannels];
-	for (uint16_t k = 0; k < m_nchannels; ++k) {
-		m_pframes[k] = new float [nsize];
-		::memset(m_pframes[k], 0, nsize * sizeof(float));
+	if (presample == nullptr) {
+		for (uint16_t k = 0; k < nchannels; ++k)
+			data->pframes[k] = drumkv1_sample_new<float> (nout + 8) + 4;
 	}
 
-	uint32_t i = 0;
-	for (uint32_t j = 0; j < m_nframes; ++j) {
-		for (uint16_t k = 0; k < m_nchannels; ++k)
-			m_pframes[k][j] = buffer[i++];
+	// read, de-interleave and resample, chunk by chunk...
+	const uint32_t CHUNK_SIZE = (1 << 14);
+
+	float *buffer = new float [nchannels * CHUNK_SIZE];
+	float **pinp = new float * [nchannels];
+	for (uint16_t k = 0; k < nchannels; ++k)
+		pinp[k] = new float [CHUNK_SIZE];
+
+	// one channel per thread, unless already decoding concurrently...
+	QThreadPool *resample_pool = nullptr;
+	if (presample && nchannels > 1 && !concurrent)
+		resample_pool = new QThreadPool();
+
+	uint32_t nframes = 0;
+	uint32_t nread = 0;
+	while (nread < ninp) {
+		uint32_t nchunk = ninp - nread;
+		if (nchunk > CHUNK_SIZE)
+			nchunk = CHUNK_SIZE;
+		const int ret = ::sf_readf_float(file, buffer, nchunk);
+		if (ret <= 0)
+			break;
+		nchunk = uint32_t(ret);
+		if (presample) {
+			for (uint16_t k = 0; k < nchannels; ++k) {
+				float *frames = pinp[k];
+				for (uint32_t j = 0; j < nchunk; ++j)
+					frames[j] = buffer[j * nchannels + k];
+				presample[k]->feed(frames, nchunk);
+			}
+			if (resample_pool) {
+				// the first channel on our own...
+				for (uint16_t k = 1; k < nchannels; ++k)
+					resample_pool->start(presample[k]);
+				presample[0]->run();
+				resample_pool->waitForDone();
+			} else {
+				for (uint16_t k = 0; k < nchannels; ++k)
+					presample[k]->run();
+			}
+			nframes = presample[0]->count();
+		} else {
+			for (uint16_t k = 0; k < nchannels; ++k) {
+				float *frames = data->pframes[k] + nread;
+				for (uint32_t j = 0; j < nchunk; ++j)
+					frames[j] = buffer[j * nchannels + k];
+			}
+			nframes = nread + nchunk;
+		}
+		nread += nchunk;
 	}
 
+	if (resample_pool)
+		delete resample_pool;
+
+	for (uint16_t k = 0; k < nchannels; ++k)
+		delete [] pinp[k];
+	delete [] pinp;
 	delete [] buffer;
+
+	if (presample) {
+		for (uint16_t k = 0; k < nchannels; ++k)
+			delete presample[k];
+		delete [] presample;
+		// identical rates now...
+		data->rate0 = float(rout);
+	}
+
 	::sf_close(file);
 
-	if (m_reverse)
-		reverse_sync();
+	// zero padding (and any frames left short)...
+	data->nframes = nframes;
+	for (uint16_t k = 0; k < nchannels; ++k) {
+		float *frames = data->pframes[k];
+		::memset(frames - 4, 0, 4 * sizeof(float));
+		::memset(frames + nframes, 0, (nout - nframes + 4) * sizeof(float));
+	}
+
+	// keep it cached on disk for next time...
+	drumkv1_sample_cache::save(data);
+
+	// stream from the cached file instead, if long enough...
+	if (isStreaming() && nframes >= drumkv1_sample_stream::MIN_LENGTH) {
+		drumkv1_sample_data *data2
+			= new drumkv1_sample_data(filename, mtime, srate, format);
+		if (drumkv1_sample_cache::load(data2)) {
+			delete data;
+			data = data2;
+		}
+		else delete data2;
+	}
+
+	return lock(compact(stream(zero_crossings(data))));
+}
+
+
+// build the zero-crossings index (all channels).
+drumkv1_sample_data *drumkv1_sample_pool::zero_crossings (
+	drumkv1_sample_data *data )
+{
+	const uint16_t nchannels = data->nchannels;
+	const uint32_t nframes = data->nframes;
+	if (nchannels < 1 || nframes < 2)
+		return data;
+
+	// crossing in between frame positions (i - 1) and i,
+	// on actual sign changes only (once per zero run)...
+	uint32_t *pzeros = nullptr;
+	uint32_t nzeros = 0;
+
+	// first pass counts, second one fills in...
+	for (int pass = 0; pass < 2; ++pass) {
+		if (pass > 0)
+			pzeros = drumkv1_sample_new<uint32_t> (nzeros > 0 ? nzeros : 1);
+		nzeros = 0;
+		float v0 = 0.0f;
+		for (uint16_t k = 0; k < nchannels; ++k)
+			v0 += data->pframes[k][0];
+		for (uint32_t i = 1; i < nframes; ++i) {
+			float v1 = 0.0f;
+			for (uint16_t k = 0; k < nchannels; ++k)
+				v1 += data->pframes[k][i];
+			if ((v0 < 0.0f) != (v1 < 0.0f)) {
+				if (pzeros)
+					pzeros[nzeros] = i;
+				++nzeros;
+			}
+			v0 = v1;
+		}
+	}
+
+	data->nzeros = nzeros;
+	data->pzeros = pzeros;
+
+	return data;
+}
+
+
+// keep only the head (and tail) resident, if long enough.
+drumkv1_sample_data *drumkv1_sample_pool::stream ( drumkv1_sample_data *data )
+{
+	// only mapped (cached) frames may be streamed...
+	if (isStreaming() && data->map_addr
+		&& data->nframes >= drumkv1_sample_stream::MIN_LENGTH) {
+		const uint32_t nhead = drumkv1_sample_stream::HEAD_SIZE;
+		const uint32_t nsize = nhead + 4;
+		const uint32_t ntail = data->nframes - nhead;
+		data->head_nframes = nhead;
+		data->head_pframes = new float * [data->nchannels];
+		data->tail_pframes = new float * [data->nchannels];
+		for (uint16_t k = 0; k < data->nchannels; ++k) {
+			// head: first frames (plus 4 following)...
+			float *head = drumkv1_sample_new<float> (nsize);
+			::memcpy(head, data->pframes[k], nsize * sizeof(float));
+			data->head_pframes[k] = head;
+			// tail: last frames (plus 4 preceding and zero padding)...
+			float *tail = drumkv1_sample_new<float> (nsize + 4);
+			::memcpy(tail, data->pframes[k] + ntail - 4, nsize * sizeof(float));
+			::memset(tail + nsize, 0, 4 * sizeof(float));
+			data->tail_pframes[k] = tail + 4;
+		}
+		drumkv1_sample_stream::attach_data(data);
+	} else {
+		// resident frames: copy out of the mapping (cached), as the
+		// file pages would be faulted in (and may get evicted later)
+		// on the audio thread; compact ones are converted anyway...
+		if (data->map_addr && data->format == drumkv1_sample_data::Float) {
+			const uint32_t nsize = data->nframes + 8;
+			for (uint16_t k = 0; k < data->nchannels; ++k) {
+				float *frames = drumkv1_sample_new<float> (nsize);
+				::memcpy(frames, data->pframes[k] - 4, nsize * sizeof(float));
+				data->pframes[k] = frames + 4;
+			}
+			drumkv1_sample_cache::unmap(data->map_addr, data->map_size);
+			data->map_addr = nullptr;
+			data->map_size = 0;
+		}
+		data->head_nframes = data->nframes;
+		data->head_pframes = data->pframes;
+		data->tail_pframes = data->pframes;
+	}
+
+	return data;
+}
+
+
+// convert resident frames to compact format, if not streamed.
+drumkv1_sample_data *drumkv1_sample_pool::compact ( drumkv1_sample_data *data )
+{
+	if (data->format == drumkv1_sample_data::Float
+		|| data->pframes == nullptr
+		|| data->head_pframes != data->pframes)
+		return data;
+
+	const uint16_t nchannels = data->nchannels;
+	const uint32_t nsize = data->nframes + 8;
+
+	data->pframes16 = new uint16_t * [nchannels];
+	for (uint16_t k = 0; k < nchannels; ++k) {
+		const float *frames = data->pframes[k] - 4;
+		uint16_t *frames16 = drumkv1_sample_new<uint16_t> (nsize);
+		if (data->format == drumkv1_sample_data::Short) {
+			for (uint32_t i = 0; i < nsize; ++i)
+				frames16[i] = uint16_t(drumkv1_simd_s16(frames[i]));
+		} else {
+			for (uint32_t i = 0; i < nsize; ++i)
+				frames16[i] = drumkv1_simd_f16(frames[i]);
+		}
+		data->pframes16[k] = frames16 + 4;
+	}
+
+	// release the float frames (or mapping)...
+	if (data->map_addr) {
+		drumkv1_sample_cache::unmap(data->map_addr, data->map_size);
+		data->map_addr = nullptr;
+		data->map_size = 0;
+	} else {
+		for (uint16_t k = 0; k < nchannels; ++k)
+			drumkv1_sample_delete(data->pframes[k] - 4);
+	}
+
+	delete [] data->pframes;
+
+	data->pframes = nullptr;
+	data->head_pframes = nullptr;
+	data->tail_pframes = nullptr;
+
+	return data;
+}
+
+
+// page-lock (and prefault) resident frames, if enabled.
+drumkv1_sample_data *drumkv1_sample_pool::lock ( drumkv1_sample_data *data )
+{
+	if (!isLocking())
+		return data;
+
+	if (!data->mlock(true)) {
+		qWarning("drumkv1_sample_pool::lock(\"%s\"): "
+			"page-lock failed (%s); prefaulted only.",
+			data->filename, ::strerror(errno));
+	}
+
+	return data;
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample - sampler wave table.
+//
+
+// ctor.
+drumkv1_sample::drumkv1_sample ( float srate )
+	: m_srate(srate), m_filename(nullptr), m_nchannels(0),
+		m_rate0(0.0f), m_freq0(1.0f), m_ratio(0.0f),
+		m_nframes(0), m_pframes(nullptr), m_pframes16(nullptr),
+		m_format(drumkv1_sample_data::Float), m_reverse(false),
+		m_data(nullptr), m_hazard(nullptr), m_offset(false), m_offset_start(0),
+		m_offset_end(0), m_offset_phase0(0.0f), m_offset_end2(0)
+{
+}
+
+
+// dtor.
+drumkv1_sample::~drumkv1_sample (void)
+{
+	close();
+
+	reclaim(true);
+}
+
+
+// init.
+bool drumkv1_sample::open ( const char *filename, float freq0 )
+{
+	if (filename == nullptr)
+		return false;
+
+	// decode (or share) first, then swap...
+	drumkv1_sample_data *data
+		= drumkv1_sample_pool::acquire(filename, m_srate);
+	char *new_filename = ::strdup(filename);
+
+	if (data == nullptr) {
+		close();
+		m_filename = new_filename;
+		return false;
+	}
+
+	if (m_filename)
+		::free(m_filename);
+
+	m_filename = new_filename;
+
+	attach(data);
 
 	reset(freq0);
 
-	updateOffset();
+	setOffsetRange(0, 0);
 	return true;
 }
 
 
 void drumkv1_sample::close (void)
 {
-	if (m_pframes) {
-		for (uint16_t k = 0; k < m_nchannels; ++k)
-			delete [] m_pframes[k];
-		delete [] m_pframes;
-		m_pframes = nullptr;
-	}
+	attach(nullptr);
 
-	m_nframes   = 0;
 	m_ratio     = 0.0f;
 	m_freq0     = 1.0f;
-	m_rate0     = 0.0f;
-	m_nchannels = 0;
 
 	setOffsetRange(0, 0);
 
@@ -150,21 +843,74 @@ void drumkv1_sample::close (void)
 }
 
 
-// reverse sample buffer.
-void drumkv1_sample::reverse_sync (void)
+// (re)attach shared sample data.
+void drumkv1_sample::attach ( drumkv1_sample_data *data )
 {
-	if (m_nframes > 0 && m_pframes) {
-		const uint32_t nsize1 = (m_nframes - 1);
-		const uint32_t nsize2 = (m_nframes >> 1);
-		for (uint16_t k = 0; k < m_nchannels; ++k) {
-			float *frames = m_pframes[k];
-			for (uint32_t i = 0; i < nsize2; ++i) {
-				const uint32_t j = nsize1 - i;
-				const float sample = frames[i];
-				frames[i] = frames[j];
-				frames[j] = sample;
-			}
+	if (data) {
+		m_nchannels = data->nchannels;
+		m_rate0     = data->rate0;
+		m_nframes   = data->nframes;
+		m_pframes   = data->pframes;
+		m_pframes16 = data->pframes16;
+		m_format    = data->format;
+	} else {
+		m_pframes   = nullptr;
+		m_pframes16 = nullptr;
+		m_format    = drumkv1_sample_data::Float;
+		m_nframes   = 0;
+		m_rate0     = 0.0f;
+		m_nchannels = 0;
+	}
+
+	// publish (swap) and retire the old one...
+	drumkv1_sample_data *old_data = m_data.exchange(data);
+	if (old_data)
+		m_retired.append(new Retired(old_data));
+
+	reclaim();
+}
+
+
+// current sample data, for playing (RT-safe).
+drumkv1_sample_data *drumkv1_sample::acquire_data (void)
+{
+	// hazard-protected, against retirement...
+	drumkv1_sample_data *data = m_data.load();
+	for (;;) {
+		m_hazard.store(data);
+		drumkv1_sample_data *data2 = m_data.load();
+		if (data2 == data)
+			break;
+		data = data2;
+	}
+
+	if (data)
+		++(data->users);
+
+	m_hazard.store(nullptr);
+
+	return data;
+}
+
+
+// free retired sample data, no longer playing.
+void drumkv1_sample::reclaim ( bool force )
+{
+	Retired *retired = m_retired.next();
+	while (retired) {
+		Retired *retired_next = retired->next();
+		drumkv1_sample_data *data = retired->data;
+		// mind the order: the hazard must be checked *before* the
+		// users count, as a reader clears its hazard only after
+		// having bumped the count; the other way around, one may
+		// miss both the hazard and the count (all seq_cst) when
+		// the reader gets in-between...
+		if (force || (m_hazard.load() != data && data->users.load() == 0)) {
+			m_retired.remove(retired);
+			drumkv1_sample_pool::release(data);
+			delete retired;
 		}
+		retired = retired_next;
 	}
 }
 
@@ -187,8 +933,8 @@ void drumkv1_sample::setOffsetRange ( uint32_t start, uint32_t end )
 	}
 
 	if (m_offset && m_offset_start < m_offset_end) {
-		m_offset_phase0 = float(zero_crossing(m_offset_start, nullptr));
-		m_offset_end2 = zero_crossing(m_offset_end, nullptr);
+		m_offset_phase0 = float(zero_crossing(m_offset_start));
+		m_offset_end2 = zero_crossing(m_offset_end);
 	} else {
 		m_offset_phase0 = 0.0f;
 		m_offset_end2 = m_nframes;
@@ -203,34 +949,44 @@ void drumkv1_sample::updateOffset (void)
 }
 
 
-// zero-crossing aliasing (all channels).
-uint32_t drumkv1_sample::zero_crossing ( uint32_t i, int *slope ) const
+// zero-crossing aliasing (all channels; binary search).
+uint32_t drumkv1_sample::zero_crossing ( uint32_t i ) const
 {
-	const int s0 = (slope ? *slope : 0);
-
-	if (i > 0) --i;
-	float v0 = zero_crossing_k(i);
-	for (++i; i < m_nframes; ++i) {
-		const float v1 = zero_crossing_k(i);
-		if ((0 >= s0 && v0 >= 0.0f && 0.0f >= v1) ||
-			(s0 >= 0 && v1 >= 0.0f && 0.0f >= v0)) {
-			if (slope && s0 == 0) *slope = (v1 < v0 ? -1 : +1);
-			return i;
+	const drumkv1_sample_data *data = m_data.load();
+	if (data == nullptr || data->nzeros < 1)
+		return m_nframes;
+
+	const uint32_t *pzeros = data->pzeros;
+	const uint32_t nzeros = data->nzeros;
+
+	if (i < 1) i = 1;
+
+	if (m_reverse) {
+		// last crossing at or before (reversed) frame position...
+		if (i > m_nframes)
+			return m_nframes;
+		const uint32_t j = m_nframes - i;
+		uint32_t lo = 0, hi = nzeros;
+		while (lo < hi) {
+			const uint32_t mid = (lo + hi) >> 1;
+			if (pzeros[mid] <= j)
+				lo = mid + 1;
+			else
+				hi = mid;
 		}
-		v0 = v1;
+		return (lo > 0 ? m_nframes - pzeros[lo - 1] : m_nframes);
 	}
 
-	return m_nframes;
-}
-
-
-// zero-crossing aliasing (median).
-float drumkv1_sample::zero_crossing_k ( uint32_t i ) const
-{
-	float sum = 0.0f;
-	for (uint16_t k = 0; k < m_nchannels; ++k)
-		sum += m_pframes[k][i];
-	return (sum / float(m_nchannels));
+	// first crossing at or after frame position...
+	uint32_t lo = 0, hi = nzeros;
+	while (lo < hi) {
+		const uint32_t mid = (lo + hi) >> 1;
+		if (pzeros[mid] < i)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return (lo < nzeros ? pzeros[lo] : m_nframes);
 }
 
 
@@ -27,10 +27,156 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <time.h>
+
+#include <atomic>
+
+#include "drumkv1_list.h"
+
+#include "drumkv1_sample_stream.h"
+
+#include "drumkv1_simd.h"
+
 // forward decls.
 class drumkv1;
 
 
+//-------------------------------------------------------------------------
+// drumkv1_sample_data - shared decoded sample frames (immutable).
+//
+
+class drumkv1_sample_data : public drumkv1_list<drumkv1_sample_data>
+{
+public:
+
+	// resident frames storage format.
+	enum Format { Float = 0, Short = 1, Half = 2 };
+
+	// ctor.
+	drumkv1_sample_data(const char *filename,
+		time_t mtime, float srate, Format format = Float);
+
+	// dtor.
+	~drumkv1_sample_data();
+
+	// pool key.
+	bool isKey(const char *filename,
+		time_t mtime, float srate, Format format) const;
+
+	// page-lock (and prefault) or unlock all resident frames.
+	bool mlock(bool on);
+
+	// pool key members.
+	char    *filename;
+	time_t   mtime;
+	float    srate;
+	Format   format;
+
+	// decoded (resampled) frames (4 zero frames padded on each side).
+	uint16_t nchannels;
+	float    rate0;
+	uint32_t nframes;
+	float  **pframes;
+
+	// cached frames mapping, if any.
+	void    *map_addr;
+	uint64_t map_size;
+
+	// resident head and tail frames (all, unless streamed).
+	uint32_t head_nframes;
+	float  **head_pframes;
+	float  **tail_pframes;
+
+	// compact frames (int16 or half-float; 4+4 zero padded), if any;
+	// all float frames above are released (null) in that case.
+	uint16_t **pframes16;
+
+	// zero-crossings index (sorted frame positions).
+	uint32_t nzeros;
+	uint32_t *pzeros;
+
+	// page-locked size (bytes; even if partially), or failure.
+	uint64_t lock_size;
+	bool     lock_failed;
+
+	// reference count.
+	std::atomic<int> refcount;
+
+	// playing voices count (audio thread).
+	std::atomic<uint32_t> users;
+};
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_pool - process-wide shared sample data pool.
+//
+// Identical files (same path, modification time and target sample-rate)
+// are decoded once and shared by all elements of all plugin instances,
+// as reference-counted immutable frames; reverse mode is just a matter
+// of read direction, so forward and reversed elements share them too.
+//
+
+class drumkv1_sample_pool
+{
+public:
+
+	// acquire (decode or share) sample data;
+	// concurrent: already on a decoding worker thread (kit loading),
+	// hence channels get resampled inline, not on yet another pool.
+	static drumkv1_sample_data *acquire(const char *filename, float srate,
+		bool concurrent = false);
+
+	// release (and free, when last) sample data.
+	static void release(drumkv1_sample_data *data);
+
+	// disk-streaming mode (long samples only).
+	static void setStreaming(bool streaming);
+	static bool isStreaming();
+
+	// resident frames storage format (0=float, 1=int16, 2=half-float).
+	static void setSampleFormat(int format);
+	static int sampleFormat();
+
+	// page-locked (and prefaulted) resident frames.
+	static void setLocking(bool locking);
+	static bool isLocking();
+
+	// page-locked size (bytes) and failures (all sample data).
+	static uint64_t lockedSize();
+	static uint32_t lockFailures();
+
+	// resampling quality (0=low, 1=medium, 2=high, 3=best).
+	static void setResampleQuality(int quality);
+	static int resampleQuality();
+
+protected:
+
+	// decode sample data (not shared yet).
+	static drumkv1_sample_data *decode(const char *filename,
+		time_t mtime, float srate, drumkv1_sample_data::Format format,
+		bool concurrent);
+
+	// resampling filter (half-)length, for given quality.
+	static uint32_t resample_filter(int quality);
+
+	// lookup shared sample data (pool lock held).
+	static drumkv1_sample_data *lookup(const char *filename,
+		time_t mtime, float srate, drumkv1_sample_data::Format format);
+
+	// build the zero-crossings index (all channels).
+	static drumkv1_sample_data *zero_crossings(drumkv1_sample_data *data);
+
+	// keep only the head (and tail) resident, if long enough.
+	static drumkv1_sample_data *stream(drumkv1_sample_data *data);
+
+	// convert resident frames to compact format, if not streamed.
+	static drumkv1_sample_data *compact(drumkv1_sample_data *data);
+
+	// page-lock (and prefault) resident frames, if enabled.
+	static drumkv1_sample_data *lock(drumkv1_sample_data *data);
+};
+
+
 //-------------------------------------------------------------------------
 // drumkv1_sample - sampler wave table.
 //
@@ -51,13 +197,13 @@ public:
 	float sampleRate() const
 		{ return m_srate; }
 
-	// reverse mode.
+	// reverse mode (read direction).
 	void setReverse (bool reverse)
 	{
 		if (( m_reverse && !reverse) ||
 			(!m_reverse &&  reverse)) {
 			m_reverse = reverse;
-			reverse_sync();
+			updateOffset();
 		}
 	}
 
@@ -113,22 +259,38 @@ public:
 		m_ratio = m_rate0 / (m_freq0 * m_srate);
 	}
 
-	// frame value.
-	float *frames(uint16_t k) const
-		{ return m_pframes[k]; }
+	// frame value (any storage format).
+	float frame(uint16_t k, uint32_t i) const
+	{
+		if (m_pframes16) {
+			const uint16_t h = m_pframes16[k][i];
+			if (m_format == drumkv1_sample_data::Short)
+				return float(int16_t(h)) * (1.0f / 32767.0f);
+			else
+				return drumkv1_simd_f32(h);
+		}
+		return m_pframes[k][i];
+	}
 
 	// predicate.
 	bool isOver(uint32_t index) const
-		{ return !m_pframes || (index >= m_offset_end2); }
+		{ return (index >= m_offset_end2); }
+
+	// current sample data, for playing (RT-safe).
+	drumkv1_sample_data *acquire_data();
+	static void release_data(drumkv1_sample_data *data)
+		{ if (data) --(data->users); }
+
+	// free retired sample data, no longer playing.
+	void reclaim(bool force = false);
 
 protected:
 
-	// reverse sample buffer.
-	void reverse_sync();
+	// (re)attach shared sample data.
+	void attach(drumkv1_sample_data *data);
 
-	// zero-crossing aliasing .
-	uint32_t zero_crossing(uint32_t i, int *slope) const;
-	float zero_crossing_k(uint32_t i) const;
+	// zero-crossing aliasing (index lookup).
+	uint32_t zero_crossing(uint32_t i) const;
 
 	// offset updater.
 	void updateOffset();
@@ -144,8 +306,24 @@ private:
 	float    m_ratio;
 	uint32_t m_nframes;
 	float  **m_pframes;
+	uint16_t **m_pframes16;
+	drumkv1_sample_data::Format m_format;
 	bool     m_reverse;
 
+	// current sample data (published) and hazard (audio thread).
+	std::atomic<drumkv1_sample_data *> m_data;
+	std::atomic<drumkv1_sample_data *> m_hazard;
+
+	// retired sample data (reclaimed once unused).
+	struct Retired : public drumkv1_list<Retired>
+	{
+		Retired(drumkv1_sample_data *d) : data(d) {}
+
+		drumkv1_sample_data *data;
+	};
+
+	drumkv1_list<Retired> m_retired;
+
 	bool     m_offset;
 	uint32_t m_offset_start;
 	uint32_t m_offset_end;
@@ -162,12 +340,25 @@ class drumkv1_generator
 public:
 
 	// ctor.
-	drumkv1_generator(drumkv1_sample *sample = nullptr) { reset(sample); }
+	drumkv1_generator(drumkv1_sample *sample = nullptr)
+		: m_sample(nullptr), m_data(nullptr),
+			m_format(drumkv1_sample_data::Float), m_stream(nullptr)
+		{ reset(sample); }
+
+	// dtor.
+	~drumkv1_generator()
+		{ reset(nullptr); }
 
 	// sample accessor.
 	drumkv1_sample *sample() const
 		{ return m_sample; }
 
+	// disk-streaming ring buffer (optional).
+	void setStream(drumkv1_sample_stream *stream)
+		{ m_stream = stream; }
+	drumkv1_sample_stream *stream() const
+		{ return m_stream; }
+
 	// reset.
 	void reset(drumkv1_sample *sample)
 	{
@@ -176,12 +367,60 @@ public:
 		start();
 	}
 
-	// begin.
+	// begin (hold current sample data, while playing).
 	void start(void)
 	{
+		drumkv1_sample::release_data(m_data);
+
+		m_data = (m_sample ? m_sample->acquire_data() : nullptr);
+
+		if (m_data) {
+			// reverse: read backwards, from the last frame...
+			const uint16_t k2 = (m_data->nchannels > 1 ? 1 : 0);
+			m_nframes = m_data->nframes;
+			m_nhead = m_data->head_nframes;
+			m_format = drumkv1_sample_data::Float;
+			if (m_data->pframes16) {
+				// compact: all frames resident, converted on read...
+				const uint32_t i = (m_sample->isReverse() ? m_nframes - 1 : 0);
+				m_format = m_data->format;
+				m_stride = (m_sample->isReverse() ? -1 : +1);
+				m_frames[0] = m_frames[1] = nullptr;
+				m_head[0] = m_head[1] = nullptr;
+				m_head16[0] = m_data->pframes16[0] + i;
+				m_head16[1] = m_data->pframes16[k2] + i;
+			}
+			else
+			if (m_sample->isReverse()) {
+				m_stride = -1;
+				m_frames[0] = m_data->pframes[0] + m_nframes - 1;
+				m_frames[1] = m_data->pframes[k2] + m_nframes - 1;
+				m_head[0] = m_data->tail_pframes[0] + m_nhead - 1;
+				m_head[1] = m_data->tail_pframes[k2] + m_nhead - 1;
+			} else {
+				m_stride = +1;
+				m_frames[0] = m_data->pframes[0];
+				m_frames[1] = m_data->pframes[k2];
+				m_head[0] = m_data->head_pframes[0];
+				m_head[1] = m_data->head_pframes[k2];
+			}
+		} else {
+			m_stride = +1;
+			m_frames[0] = m_frames[1] = nullptr;
+			m_head[0] = m_head[1] = nullptr;
+			m_format = drumkv1_sample_data::Float;
+			m_nframes = 0;
+			m_nhead = 0;
+		}
+
 		m_phase = (m_sample ? m_sample->offsetPhase0() : 0.0f);
 		m_index = 0;
 		m_alpha = 0.0f;
+
+		if (m_stream) {
+			m_stream->start(m_nhead < m_nframes ? m_data : nullptr,
+				uint32_t(m_phase), m_stride < 0);
+		}
 	}
 
 	// iterate.
@@ -192,6 +431,9 @@ public:
 		m_index  = uint32_t(m_phase);
 		m_alpha  = m_phase - float(m_index);
 		m_phase += delta;
+
+		if (m_stream)
+			m_stream->consume(m_index);
 	}
 
 	// sample.
@@ -200,12 +442,38 @@ public:
 		if (isOver())
 			return 0.0f;
 
-		const float *frames = m_sample->frames(k);
+		const float *frames;
+		int stride = m_stride;
+		float xs[4];
+
+		if (m_index < m_nhead && m_format != drumkv1_sample_data::Float) {
+			// compact frames, converted 4 at a time...
+			const uint16_t *p = m_head16[k & 1] + stride * int(m_index);
+			if (stride < 0)
+				p -= 3;
+			if (m_format == drumkv1_sample_data::Short)
+				drumkv1_simd_load4_s16(reinterpret_cast<const int16_t *> (p), xs);
+			else
+				drumkv1_simd_load4_f16(p, xs);
+			frames = (stride < 0 ? xs + 3 : xs);
+		}
+		else
+		if (m_index < m_nhead)
+			frames = m_head[k & 1] + stride * int(m_index);
+		else
+		if (m_stream == nullptr)
+			frames = m_frames[k & 1] + stride * int(m_index);
+		else
+		if (m_stream->frames(k, m_index, xs)) {
+			frames = xs;
+			stride = +1;
+		}
+		else return 0.0f; // stream underrun.
 
-		const float x0 = frames[m_index];
-		const float x1 = frames[m_index + 1];
-		const float x2 = frames[m_index + 2];
-		const float x3 = frames[m_index + 3];
+		const float x0 = frames[0];
+		const float x1 = frames[stride];
+		const float x2 = frames[stride * 2];
+		const float x3 = frames[stride * 3];
 
 		const float c1 = (x2 - x0) * 0.5f;
 		const float b1 = (x1 - x2);
@@ -218,13 +486,27 @@ public:
 
 	// predicate.
 	bool isOver() const
-		{ return (m_sample ? m_sample->isOver(m_index) : true); }
+		{ return (m_data ? m_index >= m_nframes
+			|| m_sample->isOver(m_index) : true); }
 
 private:
 
 	// iterator variables.
 	drumkv1_sample *m_sample;
 
+	// sample data being played.
+	drumkv1_sample_data *m_data;
+
+	const float *m_frames[2];
+	const float *m_head[2];
+	const uint16_t *m_head16[2];
+	drumkv1_sample_data::Format m_format;
+	uint32_t m_nframes;
+	uint32_t m_nhead;
+	int      m_stride;
+
+	drumkv1_sample_stream *m_stream;
+
 	float    m_phase;
 	uint32_t m_index;
 	float    m_alpha;
@@ -0,0 +1,339 @@
+// drumkv1_sample_cache.cpp
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "drumkv1_sample_cache.h"
+#include "drumkv1_sample.h"
+
+#include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <utime.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <QMutex>
+#include <QDir>
+#include <QFileInfo>
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_cache - persistent decoded sample cache (on disk).
+//
+
+// cache file header (all frames follow, per channel, 64-byte aligned).
+struct drumkv1_sample_cache_header
+{
+	char     magic[8];			// "DKV1SMPC"
+	uint32_t version;
+	uint32_t pathlen;			// source path length (follows header)
+	uint64_t fsize;				// source file size
+	int64_t  mtime;				// source file modification time
+	float    srate;				// target sample-rate
+	float    rate0;				// decoded sample-rate
+	uint32_t nchannels;
+	uint32_t nframes;			// frames per channel (plus 4+4 padding)
+	uint64_t offset;			// frames data offset
+};
+
+static const char    *CACHE_MAGIC   = "DKV1SMPC";
+static const uint32_t CACHE_VERSION = 2;
+static const char    *CACHE_SUFFIX  = ".dkc";
+
+static QMutex   g_cache_mutex;
+static char     g_cache_dir[PATH_MAX] = { '\0' };
+static uint64_t g_cache_max_size = 0;
+
+// running cache directory size (bytes; once scanned).
+static uint64_t g_cache_size = 0;
+static bool     g_cache_scanned = false;
+
+
+// simple 64-bit hash (FNV-1a).
+static uint64_t drumkv1_sample_cache_hash (
+	uint64_t hash, const void *data, uint32_t size )
+{
+	const uint8_t *p = static_cast<const uint8_t *> (data);
+	for (uint32_t i = 0; i < size; ++i) {
+		hash ^= uint64_t(p[i]);
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+
+// frames data offset (64-byte aligned).
+static uint64_t drumkv1_sample_cache_offset ( uint32_t pathlen )
+{
+	const uint64_t offset
+		= sizeof(drumkv1_sample_cache_header) + pathlen + 1;
+	return (offset + 63) & ~uint64_t(63);
+}
+
+
+// setup cache directory (empty=disabled) and size limit (MB; 0=none).
+void drumkv1_sample_cache::setup ( const char *cache_dir, uint32_t max_size_mb )
+{
+	QMutexLocker locker(&g_cache_mutex);
+
+	g_cache_dir[0] = '\0';
+	g_cache_max_size = uint64_t(max_size_mb) << 20;
+
+	g_cache_size = 0;
+	g_cache_scanned = false;
+
+	if (cache_dir && cache_dir[0]) {
+		if (QDir().mkpath(QString::fromUtf8(cache_dir))) {
+			::strncpy(g_cache_dir, cache_dir, PATH_MAX - 1);
+			g_cache_dir[PATH_MAX - 1] = '\0';
+		}
+	}
+}
+
+
+// cache file path (key).
+bool drumkv1_sample_cache::cache_path ( const drumkv1_sample_data *data,
+	char *path, uint32_t maxlen, uint64_t *fsize )
+{
+	if (g_cache_dir[0] == '\0')
+		return false;
+
+	struct stat st;
+	if (::stat(data->filename, &st) != 0)
+		return false;
+
+	*fsize = uint64_t(st.st_size);
+
+	const int64_t mtime = int64_t(data->mtime);
+	const uint32_t srate = uint32_t(data->srate);
+	const int32_t quality = drumkv1_sample_pool::resampleQuality();
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	hash = drumkv1_sample_cache_hash(hash,
+		data->filename, ::strlen(data->filename));
+	hash = drumkv1_sample_cache_hash(hash, fsize, sizeof(*fsize));
+	hash = drumkv1_sample_cache_hash(hash, &mtime, sizeof(mtime));
+	hash = drumkv1_sample_cache_hash(hash, &quality, sizeof(quality));
+
+	const int len = ::snprintf(path, maxlen, "%s/%016llx-%u%s",
+		g_cache_dir, (unsigned long long) hash, srate, CACHE_SUFFIX);
+
+	return (len > 0 && uint32_t(len) < maxlen);
+}
+
+
+// load (map) decoded frames from cache, if any.
+bool drumkv1_sample_cache::load ( drumkv1_sample_data *data )
+{
+	char path[PATH_MAX];
+	uint64_t fsize = 0;
+
+	g_cache_mutex.lock();
+	const bool ret = cache_path(data, path, sizeof(path), &fsize);
+	g_cache_mutex.unlock();
+
+	if (!ret)
+		return false;
+
+	const int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0
+		|| uint64_t(st.st_size) < sizeof(drumkv1_sample_cache_header)) {
+		::close(fd);
+		return false;
+	}
+
+	const uint64_t map_size = uint64_t(st.st_size);
+	void *map_addr = ::mmap(nullptr, map_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (map_addr == MAP_FAILED)
+		return false;
+
+	// validate header...
+	const drumkv1_sample_cache_header *header
+		= static_cast<const drumkv1_sample_cache_header *> (map_addr);
+	const char *pathname = static_cast<const char *> (map_addr)
+		+ sizeof(drumkv1_sample_cache_header);
+	const uint32_t pathlen = ::strlen(data->filename);
+	const uint64_t offset = drumkv1_sample_cache_offset(pathlen);
+	const uint64_t nsize = uint64_t(header->nchannels) * header->nframes;
+
+	if (::memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) != 0
+		|| header->version != CACHE_VERSION
+		|| header->pathlen != pathlen
+		|| header->fsize != fsize
+		|| header->mtime != int64_t(data->mtime)
+		|| header->srate != data->srate
+		|| header->nchannels < 1
+		|| header->nframes < 8
+		|| header->offset != offset
+		|| offset + nsize * sizeof(float) > map_size
+		|| ::memcmp(pathname, data->filename, pathlen) != 0) {
+		::munmap(map_addr, map_size);
+		return false;
+	}
+
+	// map frames (read-only)...
+	float *frames = reinterpret_cast<float *> (
+		static_cast<char *> (map_addr) + offset);
+
+	data->nchannels = header->nchannels;
+	data->rate0     = header->rate0;
+	data->nframes   = header->nframes - 8;
+	data->pframes   = new float * [data->nchannels];
+	for (uint16_t k = 0; k < data->nchannels; ++k)
+		data->pframes[k] = frames + k * header->nframes + 4;
+
+	data->map_addr  = map_addr;
+	data->map_size  = map_size;
+
+	// touch cache file (least-recently-used pruning)
+	::utime(path, nullptr);
+
+	return true;
+}
+
+
+// save decoded frames into cache.
+void drumkv1_sample_cache::save ( const drumkv1_sample_data *data )
+{
+	if (data->pframes == nullptr || data->nchannels < 1)
+		return;
+
+	char path[PATH_MAX];
+	uint64_t fsize = 0;
+
+	g_cache_mutex.lock();
+	const bool ret = cache_path(data, path, sizeof(path), &fsize);
+	g_cache_mutex.unlock();
+
+	if (!ret)
+		return;
+
+	char temp_path[PATH_MAX + 32];
+	::snprintf(temp_path, sizeof(temp_path), "%s.%d.%p",
+		path, int(::getpid()), (const void *) data);
+
+	FILE *file = ::fopen(temp_path, "wb");
+	if (file == nullptr)
+		return;
+
+	const uint32_t pathlen = ::strlen(data->filename);
+	const uint32_t nsize = data->nframes + 8;
+
+	drumkv1_sample_cache_header header;
+	::memset(&header, 0, sizeof(header));
+	::memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	header.version   = CACHE_VERSION;
+	header.pathlen   = pathlen;
+	header.fsize     = fsize;
+	header.mtime     = int64_t(data->mtime);
+	header.srate     = data->srate;
+	header.rate0     = data->rate0;
+	header.nchannels = data->nchannels;
+	header.nframes   = nsize;
+	header.offset    = drumkv1_sample_cache_offset(pathlen);
+
+	bool ok = (::fwrite(&header, sizeof(header), 1, file) == 1
+		&& ::fwrite(data->filename, pathlen, 1, file) == 1);
+
+	uint64_t npad = header.offset - sizeof(header) - pathlen;
+	while (ok && npad > 0) {
+		ok = (::fputc(0, file) != EOF);
+		--npad;
+	}
+
+	for (uint16_t k = 0; ok && k < data->nchannels; ++k)
+		ok = (::fwrite(data->pframes[k] - 4, sizeof(float), nsize, file) == nsize);
+
+	if (::fclose(file) != 0)
+		ok = false;
+
+	// replacing an older one?
+	struct stat st;
+	const uint64_t old_size
+		= (::stat(path, &st) == 0 ? uint64_t(st.st_size) : 0);
+
+	// publish (atomically) or discard...
+	if (!ok || ::rename(temp_path, path) != 0) {
+		::unlink(temp_path);
+		return;
+	}
+
+	// keep the running size; prune only when over limit.
+	const uint64_t new_size = header.offset
+		+ uint64_t(data->nchannels) * nsize * sizeof(float);
+
+	g_cache_mutex.lock();
+	const bool over = (g_cache_max_size > 0 && (!g_cache_scanned
+		|| g_cache_size - old_size + new_size > g_cache_max_size));
+	if (g_cache_scanned)
+		g_cache_size += new_size - old_size;
+	g_cache_mutex.unlock();
+
+	if (over)
+		prune();
+}
+
+
+// unmap cached frames.
+void drumkv1_sample_cache::unmap ( void *addr, uint64_t size )
+{
+	if (addr) ::munmap(addr, size);
+}
+
+
+// prune oldest cache files (above size limit);
+// rescans the whole cache directory (running size).
+void drumkv1_sample_cache::prune (void)
+{
+	QMutexLocker locker(&g_cache_mutex);
+
+	if (g_cache_dir[0] == '\0' || g_cache_max_size < 1)
+		return;
+
+	const QDir dir(QString::fromUtf8(g_cache_dir));
+	const QFileInfoList& list = dir.entryInfoList(
+		QStringList(QString("*") + CACHE_SUFFIX),
+		QDir::Files, QDir::Time | QDir::Reversed);
+
+	uint64_t total = 0;
+	foreach (const QFileInfo& info, list)
+		total += uint64_t(info.size());
+
+	foreach (const QFileInfo& info, list) {
+		if (total <= g_cache_max_size)
+			break;
+		if (QFile::remove(info.absoluteFilePath()))
+			total -= uint64_t(info.size());
+	}
+
+	g_cache_size = total;
+	g_cache_scanned = true;
+}
+
+
+// end of drumkv1_sample_cache.cpp
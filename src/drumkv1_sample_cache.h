@@ -0,0 +1,72 @@
+// drumkv1_sample_cache.h
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __drumkv1_sample_cache_h
+#define __drumkv1_sample_cache_h
+
+#include <stdint.h>
+
+// forward decls.
+class drumkv1_sample_data;
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_cache - persistent decoded sample cache (on disk).
+//
+// Already decoded, resampled and de-interleaved frames are kept as
+// plain files in a cache directory, keyed by the source file identity
+// (path, size and modification time) and target sample-rate; later
+// loads just map the cached file read-only, skipping decoding at all.
+// Only streamed samples keep playing from the mapping; resident ones
+// are copied out of it (see drumkv1_sample_pool::stream()), lest the
+// (clean, evictable) file pages get faulted in on the audio thread.
+//
+
+class drumkv1_sample_cache
+{
+public:
+
+	// setup cache directory (empty=disabled) and size limit (MB; 0=none).
+	static void setup(const char *cache_dir, uint32_t max_size_mb);
+
+	// load (map) decoded frames from cache, if any.
+	static bool load(drumkv1_sample_data *data);
+
+	// save decoded frames into cache.
+	static void save(const drumkv1_sample_data *data);
+
+	// unmap cached frames.
+	static void unmap(void *addr, uint64_t size);
+
+protected:
+
+	// cache file path (key).
+	static bool cache_path(const drumkv1_sample_data *data,
+		char *path, uint32_t maxlen, uint64_t *fsize);
+
+	// prune oldest cache files (above size limit; rescan).
+	static void prune();
+};
+
+
+#endif	// __drumkv1_sample_cache_h
+
+// end of drumkv1_sample_cache.h
@@ -0,0 +1,279 @@
+// drumkv1_sample_stream.cpp
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "drumkv1_sample_stream.h"
+#include "drumkv1_sample.h"
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <QList>
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_stream_thread - background reader thread decl.
+//
+
+class drumkv1_sample_stream_thread : public QThread
+{
+public:
+
+	// ctor.
+	drumkv1_sample_stream_thread();
+
+	// dtor.
+	~drumkv1_sample_stream_thread();
+
+	// wake from wait condition (RT-safe).
+	void sync();
+
+protected:
+
+	// main thread executive.
+	void run();
+
+private:
+
+	// whether the thread is logically running.
+	volatile bool m_running;
+
+	// thread synchronization objects.
+	QWaitCondition m_cond;
+};
+
+
+// all streams and (live) streamed sample data, reader thread lock.
+static QMutex g_stream_mutex;
+
+static drumkv1_list<drumkv1_sample_stream> g_stream_list;
+static QList<const drumkv1_sample_data *> g_stream_datas;
+
+static drumkv1_sample_stream_thread *g_stream_thread = nullptr;
+static uint32_t g_stream_refcount = 0;
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_stream_thread - background reader thread impl.
+//
+
+// ctor.
+drumkv1_sample_stream_thread::drumkv1_sample_stream_thread (void)
+	: QThread(), m_running(false)
+{
+}
+
+
+// dtor.
+drumkv1_sample_stream_thread::~drumkv1_sample_stream_thread (void)
+{
+	// fake sync and wait
+	if (m_running && isRunning()) do {
+		if (g_stream_mutex.tryLock()) {
+			m_running = false;
+			m_cond.wakeAll();
+			g_stream_mutex.unlock();
+		}
+	} while (!wait(100));
+}
+
+
+// wake from wait condition (RT-safe).
+void drumkv1_sample_stream_thread::sync (void)
+{
+	if (g_stream_mutex.tryLock()) {
+		m_cond.wakeAll();
+		g_stream_mutex.unlock();
+	}
+}
+
+
+// main thread executive.
+void drumkv1_sample_stream_thread::run (void)
+{
+	g_stream_mutex.lock();
+
+	m_running = true;
+
+	while (m_running) {
+		// read-ahead all active streams...
+		bool active = false;
+		uint32_t nread = 0;
+		drumkv1_sample_stream *stream = g_stream_list.next();
+		while (stream) {
+			if (stream->data()) {
+				nread += stream->fill();
+				active = true;
+			}
+			stream = stream->next();
+		}
+		// wait for sync (or poll while streaming)...
+		if (nread == 0)
+			m_cond.wait(&g_stream_mutex, active ? 5 : 100);
+	}
+
+	g_stream_mutex.unlock();
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_stream - per-voice disk streaming ring buffer.
+//
+
+// ctor.
+drumkv1_sample_stream::drumkv1_sample_stream (void)
+	: m_data(nullptr), m_reverse(false),
+		m_gen(0), m_start(0), m_state(0), m_read(0)
+{
+	for (uint16_t k = 0; k < MAX_CHANNELS; ++k) {
+		m_ring[k] = new float [RING_SIZE];
+		::memset(m_ring[k], 0, RING_SIZE * sizeof(float));
+	}
+
+	QMutexLocker locker(&g_stream_mutex);
+
+	g_stream_list.append(this);
+
+	if (++g_stream_refcount == 1 && g_stream_thread == nullptr) {
+		g_stream_thread = new drumkv1_sample_stream_thread();
+		g_stream_thread->start();
+	}
+}
+
+
+// dtor.
+drumkv1_sample_stream::~drumkv1_sample_stream (void)
+{
+	drumkv1_sample_stream_thread *thread = nullptr;
+
+	g_stream_mutex.lock();
+	g_stream_list.remove(this);
+	if (--g_stream_refcount == 0) {
+		thread = g_stream_thread;
+		g_stream_thread = nullptr;
+	}
+	g_stream_mutex.unlock();
+
+	if (thread)
+		delete thread;
+
+	for (uint16_t k = 0; k < MAX_CHANNELS; ++k)
+		delete [] m_ring[k];
+}
+
+
+// (re)start streaming from given frame index (RT-safe).
+void drumkv1_sample_stream::start (
+	const drumkv1_sample_data *data, uint32_t index, bool reverse )
+{
+	++m_gen;
+
+	m_start = 0;
+	if (data) {
+		m_start = data->head_nframes;
+		if (m_start < index)
+			m_start = index;
+	}
+
+	m_read.store(m_start, std::memory_order_relaxed);
+	m_reverse.store(reverse, std::memory_order_relaxed);
+	m_data.store(data, std::memory_order_release);
+	m_state.store((uint64_t(m_gen) << 32) | m_start, std::memory_order_release);
+
+	if (data && g_stream_thread)
+		g_stream_thread->sync();
+}
+
+
+// register/unregister streamed sample data (non-RT).
+void drumkv1_sample_stream::attach_data ( const drumkv1_sample_data *data )
+{
+	QMutexLocker locker(&g_stream_mutex);
+
+	g_stream_datas.append(data);
+}
+
+
+void drumkv1_sample_stream::detach_data ( const drumkv1_sample_data *data )
+{
+	QMutexLocker locker(&g_stream_mutex);
+
+	g_stream_datas.removeAll(data);
+}
+
+
+// read-ahead (reader thread; returns frames read).
+uint32_t drumkv1_sample_stream::fill (void)
+{
+	// state first, then its own (or newer) data...
+	const uint64_t state = m_state.load(std::memory_order_acquire);
+	const drumkv1_sample_data *data = m_data.load(std::memory_order_acquire);
+	if (data == nullptr || !g_stream_datas.contains(data))
+		return 0;
+
+	const uint32_t iread  = m_read.load(std::memory_order_acquire);
+	const uint32_t iwrite = uint32_t(state);
+	if (iread + RING_SIZE <= iwrite)
+		return 0;
+
+	uint32_t nread = iread + RING_SIZE - iwrite;
+	if (nread > CHUNK_SIZE)
+		nread = CHUNK_SIZE;
+
+	const uint32_t nsize = data->nframes + 4;
+	if (iwrite >= nsize)
+		return 0;
+	if (nread > nsize - iwrite)
+		nread = nsize - iwrite;
+
+	// copy from the mapped frames (may page-fault here)...
+	const bool reverse = m_reverse.load(std::memory_order_relaxed);
+	const uint32_t i = (iwrite & RING_MASK);
+	const uint32_t n1 = (i + nread > RING_SIZE ? RING_SIZE - i : nread);
+	const uint32_t n2 = nread - n1;
+	for (uint16_t k = 0; k < MAX_CHANNELS; ++k) {
+		const float *frames = data->pframes[k < data->nchannels ? k : 0];
+		if (reverse) {
+			// read backwards, from the last frame...
+			frames += int64_t(data->nframes) - 1 - int64_t(iwrite);
+			float *ring = m_ring[k];
+			for (uint32_t j = 0; j < nread; ++j)
+				ring[(iwrite + j) & RING_MASK] = *frames--;
+		} else {
+			frames += iwrite;
+			::memcpy(m_ring[k] + i, frames, n1 * sizeof(float));
+			if (n2 > 0)
+				::memcpy(m_ring[k], frames + n1, n2 * sizeof(float));
+		}
+	}
+
+	// publish, unless restarted meanwhile...
+	uint64_t expected = state;
+	const uint64_t desired = (state & 0xffffffff00000000ULL) | (iwrite + nread);
+	if (!m_state.compare_exchange_strong(expected, desired,
+			std::memory_order_acq_rel, std::memory_order_relaxed))
+		return 0;
+
+	return nread;
+}
+
+
+// end of drumkv1_sample_stream.cpp
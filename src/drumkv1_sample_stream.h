@@ -0,0 +1,131 @@
+// drumkv1_sample_stream.h
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __drumkv1_sample_stream_h
+#define __drumkv1_sample_stream_h
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "drumkv1_list.h"
+
+// forward decls.
+class drumkv1_sample_data;
+
+
+//-------------------------------------------------------------------------
+// drumkv1_sample_stream - per-voice disk streaming ring buffer.
+//
+// Long samples keep only a head resident in memory, the remaining
+// frames being read ahead from the (memory-mapped) decoded sample
+// cache file by a background reader thread, into these per-voice
+// ring buffers, which are the only ones touched by the audio thread.
+//
+
+class drumkv1_sample_stream : public drumkv1_list<drumkv1_sample_stream>
+{
+public:
+
+	// resident head length (frames).
+	static const uint32_t HEAD_SIZE  = (1 << 16);	// = 65536
+
+	// minimum sample length for streaming (frames).
+	static const uint32_t MIN_LENGTH = (HEAD_SIZE << 2);
+
+	// ring buffer length and read-ahead chunk size (frames).
+	static const uint32_t RING_SIZE  = (1 << 14);	// = 16384
+	static const uint32_t RING_MASK  = RING_SIZE - 1;
+	static const uint32_t CHUNK_SIZE = (1 << 11);	// = 2048
+
+	// max. streamed channels.
+	static const uint16_t MAX_CHANNELS = 2;
+
+	// ctor.
+	drumkv1_sample_stream();
+
+	// dtor.
+	~drumkv1_sample_stream();
+
+	// (re)start streaming from given frame index (RT-safe).
+	void start(const drumkv1_sample_data *data,
+		uint32_t index, bool reverse = false);
+
+	// stop streaming (RT-safe).
+	void stop()
+		{ start(nullptr, 0); }
+
+	// consumer (play-head) position (RT-safe).
+	void consume(uint32_t index)
+	{
+		if (index > m_start)
+			m_read.store(index, std::memory_order_release);
+	}
+
+	// current sample data.
+	const drumkv1_sample_data *data() const
+		{ return m_data.load(std::memory_order_acquire); }
+
+	// frame values at index..index+3 (RT-safe; false on underrun).
+	bool frames(uint16_t k, uint32_t index, float *x) const
+	{
+		const uint64_t state = m_state.load(std::memory_order_acquire);
+		if (uint32_t(state >> 32) != m_gen
+			|| index < m_start || index + 4 > uint32_t(state))
+			return false;
+		const float *ring = m_ring[k < MAX_CHANNELS ? k : 0];
+		x[0] = ring[(index    ) & RING_MASK];
+		x[1] = ring[(index + 1) & RING_MASK];
+		x[2] = ring[(index + 2) & RING_MASK];
+		x[3] = ring[(index + 3) & RING_MASK];
+		return true;
+	}
+
+	// register/unregister streamed sample data (non-RT).
+	static void attach_data(const drumkv1_sample_data *data);
+	static void detach_data(const drumkv1_sample_data *data);
+
+	// read-ahead (reader thread; returns frames read).
+	uint32_t fill();
+
+private:
+
+	// ring buffers (per channel).
+	float *m_ring[MAX_CHANNELS];
+
+	// current sample data and generation (owned by the audio thread).
+	std::atomic<const drumkv1_sample_data *> m_data;
+	std::atomic<bool> m_reverse;
+
+	uint32_t m_gen;
+	uint32_t m_start;
+
+	// generation (high) and write position (low) state.
+	std::atomic<uint64_t> m_state;
+
+	// consumer (play-head) position.
+	std::atomic<uint32_t> m_read;
+};
+
+
+#endif	// __drumkv1_sample_stream_h
+
+// end of drumkv1_sample_stream.h
@@ -0,0 +1,503 @@
+// drumkv1_simd.h
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __drumkv1_simd_h
+#define __drumkv1_simd_h
+
+#include <stdint.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+//-------------------------------------------------------------------------
+// drumkv1_simd - vectorized block kernels (staged voice rendering).
+//
+// All buffers are plain float arrays, not necessarily aligned;
+// the AVX/SSE2 paths are selected at compile time, whenever the
+// target architecture flags allow (eg. -mavx2), otherwise falls
+// back to plain scalar loops.
+//
+
+// y[n] *= x[n]
+
+inline void drumkv1_simd_mul ( float *y, const float *x, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__AVX__)
+	for (; n + 8 <= nframes; n += 8) {
+		_mm256_storeu_ps(y + n, _mm256_mul_ps(
+			_mm256_loadu_ps(y + n), _mm256_loadu_ps(x + n)));
+	}
+#endif
+#if defined(__SSE2__)
+	for (; n + 4 <= nframes; n += 4) {
+		_mm_storeu_ps(y + n, _mm_mul_ps(
+			_mm_loadu_ps(y + n), _mm_loadu_ps(x + n)));
+	}
+#endif
+	for (; n < nframes; ++n)
+		y[n] *= x[n];
+}
+
+
+// y[n] += x[n]
+
+inline void drumkv1_simd_add ( float *y, const float *x, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__AVX__)
+	for (; n + 8 <= nframes; n += 8) {
+		_mm256_storeu_ps(y + n, _mm256_add_ps(
+			_mm256_loadu_ps(y + n), _mm256_loadu_ps(x + n)));
+	}
+#endif
+#if defined(__SSE2__)
+	for (; n + 4 <= nframes; n += 4) {
+		_mm_storeu_ps(y + n, _mm_add_ps(
+			_mm_loadu_ps(y + n), _mm_loadu_ps(x + n)));
+	}
+#endif
+	for (; n < nframes; ++n)
+		y[n] += x[n];
+}
+
+
+// stereo width (mid/side) in-place:
+//   y1[n] = mid + side * w[n], y2[n] = mid - side * w[n]
+
+inline void drumkv1_simd_width (
+	float *y1, float *y2, const float *w, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__AVX__)
+	const __m256 h8 = _mm256_set1_ps(0.5f);
+	for (; n + 8 <= nframes; n += 8) {
+		const __m256 x1 = _mm256_loadu_ps(y1 + n);
+		const __m256 x2 = _mm256_loadu_ps(y2 + n);
+		const __m256 m1 = _mm256_mul_ps(h8, _mm256_add_ps(x1, x2));
+		const __m256 s1 = _mm256_mul_ps(_mm256_mul_ps(h8,
+			_mm256_sub_ps(x1, x2)), _mm256_loadu_ps(w + n));
+		_mm256_storeu_ps(y1 + n, _mm256_add_ps(m1, s1));
+		_mm256_storeu_ps(y2 + n, _mm256_sub_ps(m1, s1));
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128 h4 = _mm_set1_ps(0.5f);
+	for (; n + 4 <= nframes; n += 4) {
+		const __m128 x1 = _mm_loadu_ps(y1 + n);
+		const __m128 x2 = _mm_loadu_ps(y2 + n);
+		const __m128 m1 = _mm_mul_ps(h4, _mm_add_ps(x1, x2));
+		const __m128 s1 = _mm_mul_ps(_mm_mul_ps(h4,
+			_mm_sub_ps(x1, x2)), _mm_loadu_ps(w + n));
+		_mm_storeu_ps(y1 + n, _mm_add_ps(m1, s1));
+		_mm_storeu_ps(y2 + n, _mm_sub_ps(m1, s1));
+	}
+#endif
+	for (; n < nframes; ++n) {
+		const float m1 = 0.5f * (y1[n] + y2[n]);
+		const float s1 = 0.5f * (y1[n] - y2[n]) * w[n];
+		y1[n] = m1 + s1;
+		y2[n] = m1 - s1;
+	}
+}
+
+
+// dry/wet mix-down (accumulate):
+//   out[n] += x[n] - wet * x[n], sfx[n] += wet * x[n]
+
+inline void drumkv1_simd_mix ( float *out, float *sfx,
+	const float *x, float wet, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__AVX__)
+	const __m256 w8 = _mm256_set1_ps(wet);
+	for (; n + 8 <= nframes; n += 8) {
+		const __m256 x8 = _mm256_loadu_ps(x + n);
+		const __m256 y8 = _mm256_mul_ps(w8, x8);
+		_mm256_storeu_ps(out + n, _mm256_add_ps(
+			_mm256_loadu_ps(out + n), _mm256_sub_ps(x8, y8)));
+		_mm256_storeu_ps(sfx + n, _mm256_add_ps(
+			_mm256_loadu_ps(sfx + n), y8));
+	}
+#endif
+#if defined(__SSE2__)
+	const __m128 w4 = _mm_set1_ps(wet);
+	for (; n + 4 <= nframes; n += 4) {
+		const __m128 x4 = _mm_loadu_ps(x + n);
+		const __m128 y4 = _mm_mul_ps(w4, x4);
+		_mm_storeu_ps(out + n, _mm_add_ps(
+			_mm_loadu_ps(out + n), _mm_sub_ps(x4, y4)));
+		_mm_storeu_ps(sfx + n, _mm_add_ps(
+			_mm_loadu_ps(sfx + n), y4));
+	}
+#endif
+	for (; n < nframes; ++n) {
+		const float y = wet * x[n];
+		out[n] += x[n] - y;
+		sfx[n] += y;
+	}
+}
+
+
+// absolute peak (running maximum):
+//   returns max(peak, |x[n]|)
+
+inline float drumkv1_simd_peak ( const float *x, uint32_t nframes, float peak )
+{
+	uint32_t n = 0;
+#if defined(__SSE2__)
+	const __m128 m4 = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 p4 = _mm_set1_ps(peak);
+	for (; n + 4 <= nframes; n += 4)
+		p4 = _mm_max_ps(p4, _mm_and_ps(m4, _mm_loadu_ps(x + n)));
+	p4 = _mm_max_ps(p4, _mm_movehl_ps(p4, p4));
+	p4 = _mm_max_ss(p4, _mm_shuffle_ps(p4, p4, 1));
+	peak = _mm_cvtss_f32(p4);
+#endif
+	for (; n < nframes; ++n) {
+		const float a = (x[n] < 0.0f ? -x[n] : x[n]);
+		if (peak < a)
+			peak = a;
+	}
+	return peak;
+}
+
+
+// dual inner product (polyphase filter):
+//   returns sum(a[n] * x[n] + b[n] * y[n])
+
+inline float drumkv1_simd_dot2 ( const float *a, const float *x,
+	const float *b, const float *y, uint32_t nframes )
+{
+	float sum = 0.0f;
+	uint32_t n = 0;
+#if defined(__AVX__)
+	__m256 s8 = _mm256_setzero_ps();
+	for (; n + 8 <= nframes; n += 8) {
+		s8 = _mm256_add_ps(s8, _mm256_add_ps(
+			_mm256_mul_ps(_mm256_loadu_ps(a + n), _mm256_loadu_ps(x + n)),
+			_mm256_mul_ps(_mm256_loadu_ps(b + n), _mm256_loadu_ps(y + n))));
+	}
+	__m128 s4 = _mm_add_ps(
+		_mm256_castps256_ps128(s8), _mm256_extractf128_ps(s8, 1));
+#elif defined(__SSE2__)
+	__m128 s4 = _mm_setzero_ps();
+#endif
+#if defined(__SSE2__)
+	for (; n + 4 <= nframes; n += 4) {
+		s4 = _mm_add_ps(s4, _mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(a + n), _mm_loadu_ps(x + n)),
+			_mm_mul_ps(_mm_loadu_ps(b + n), _mm_loadu_ps(y + n))));
+	}
+	s4 = _mm_add_ps(s4, _mm_movehl_ps(s4, s4));
+	s4 = _mm_add_ss(s4, _mm_shuffle_ps(s4, s4, 1));
+	sum = _mm_cvtss_f32(s4);
+#endif
+	for (; n < nframes; ++n)
+		sum += a[n] * x[n] + b[n] * y[n];
+	return sum;
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_simd - compact sample frames (int16 or IEEE half-float).
+//
+
+// float to int16 (clipped, rounded; load-time only).
+
+inline int16_t drumkv1_simd_s16 ( float x )
+{
+	if (x > 1.0f)
+		x = 1.0f;
+	else
+	if (x < -1.0f)
+		x = -1.0f;
+	x *= 32767.0f;
+	return int16_t(x < 0.0f ? x - 0.5f : x + 0.5f);
+}
+
+
+// float to half-float (round to nearest even; load-time only).
+
+inline uint16_t drumkv1_simd_f16 ( float x )
+{
+	union { float f; uint32_t u; } v, m;
+	v.f = x;
+
+	const uint32_t sign = (v.u >> 16) & 0x8000;
+	v.u &= 0x7fffffff;
+
+	uint16_t h;
+	if (v.u >= 0x47800000) {
+		// overflow (or inf/nan)...
+		h = (v.u > 0x7f800000 ? 0x7e00 : 0x7c00);
+	}
+	else
+	if (v.u < 0x38800000) {
+		// subnormal (or zero)...
+		m.u = ((127 - 15) + (23 - 10) + 1) << 23;
+		v.f += m.f;
+		h = uint16_t(v.u - m.u);
+	} else {
+		// normal...
+		const uint32_t odd = (v.u >> 13) & 1;
+		v.u += uint32_t(15 - 127) << 23;
+		v.u += 0xfff + odd;
+		h = uint16_t(v.u >> 13);
+	}
+
+	return h | uint16_t(sign);
+}
+
+
+// half-float to float (scalar).
+
+inline float drumkv1_simd_f32 ( uint16_t h )
+{
+	union { float f; uint32_t u; } v, m;
+
+	m.u = (254 - 15) << 23;
+	v.u = uint32_t(h & 0x7fff) << 13;
+	v.f *= m.f;
+	if (v.f >= 65536.0f)
+		v.u |= 255 << 23;
+	v.u |= uint32_t(h & 0x8000) << 16;
+
+	return v.f;
+}
+
+
+// x[0..3] = p[0..3] / 32767 (int16 frames)
+
+inline void drumkv1_simd_load4_s16 ( const int16_t *p, float *x )
+{
+#if defined(__SSE2__)
+	const __m128i s4 = _mm_loadl_epi64(reinterpret_cast<const __m128i *> (p));
+	const __m128i i4 = _mm_srai_epi32(_mm_unpacklo_epi16(s4, s4), 16);
+	_mm_storeu_ps(x, _mm_mul_ps(_mm_cvtepi32_ps(i4),
+		_mm_set1_ps(1.0f / 32767.0f)));
+#else
+	const float scale = 1.0f / 32767.0f;
+	x[0] = float(p[0]) * scale;
+	x[1] = float(p[1]) * scale;
+	x[2] = float(p[2]) * scale;
+	x[3] = float(p[3]) * scale;
+#endif
+}
+
+
+// x[0..3] = float(p[0..3]) (half-float frames)
+
+inline void drumkv1_simd_load4_f16 ( const uint16_t *p, float *x )
+{
+#if defined(__F16C__)
+	_mm_storeu_ps(x, _mm_cvtph_ps(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i *> (p))));
+#elif defined(__SSE2__)
+	const __m128i h4 = _mm_unpacklo_epi16(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i *> (p)),
+		_mm_setzero_si128());
+	const __m128i em = _mm_and_si128(h4, _mm_set1_epi32(0x7fff));
+	const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h4, em), 16);
+	const __m128 scaled = _mm_mul_ps(
+		_mm_castsi128_ps(_mm_slli_epi32(em, 13)),
+		_mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+	const __m128i infnan = _mm_and_si128(
+		_mm_cmpgt_epi32(em, _mm_set1_epi32(0x7bff)),
+		_mm_set1_epi32(255 << 23));
+	_mm_storeu_ps(x, _mm_or_ps(scaled,
+		_mm_castsi128_ps(_mm_or_si128(sign, infnan))));
+#else
+	x[0] = drumkv1_simd_f32(p[0]);
+	x[1] = drumkv1_simd_f32(p[1]);
+	x[2] = drumkv1_simd_f32(p[2]);
+	x[3] = drumkv1_simd_f32(p[3]);
+#endif
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_simd - reverb (freeverb) delay line kernels.
+//
+
+// flush denormals to zero (scalar).
+
+inline float drumkv1_simd_denormal ( float x )
+{
+	union { float f; uint32_t u; } v;
+	v.f = x;
+	return (v.u & 0x7f800000) ? x : 0.0f;
+}
+
+
+#if defined(__SSE2__)
+
+// flush denormals to zero (4 lanes).
+
+inline __m128 drumkv1_simd_denormal4 ( __m128 x )
+{
+	const __m128i e4 = _mm_and_si128(
+		_mm_castps_si128(x), _mm_set1_epi32(0x7f800000));
+	return _mm_andnot_ps(_mm_castsi128_ps(
+		_mm_cmpeq_epi32(e4, _mm_setzero_si128())), x);
+}
+
+#endif
+
+
+// one-pole lowpass (comb damping), independent lanes (multiple of 4,
+// up to 32), all lanes interleaved in time, in-place:
+//   y[k][n] = s[k] = denormal(y[k][n] * (1 - d[k]) + s[k] * d[k])
+
+inline void drumkv1_simd_lpf ( float *const *y,
+	float *s, const float *d, uint32_t nlanes, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__SSE2__)
+	const uint32_t ngroups = (nlanes >> 2);
+	__m128 d4[8], e4[8], s4[8];
+	uint32_t g;
+	for (g = 0; g < ngroups; ++g) {
+		d4[g] = _mm_loadu_ps(d + (g << 2));
+		e4[g] = _mm_sub_ps(_mm_set1_ps(1.0f), d4[g]);
+		s4[g] = _mm_loadu_ps(s + (g << 2));
+	}
+	for (; n + 4 <= nframes; n += 4) {
+		for (g = 0; g < ngroups; ++g) {
+			float *const *yg = y + (g << 2);
+			__m128 r0 = _mm_loadu_ps(yg[0] + n);
+			__m128 r1 = _mm_loadu_ps(yg[1] + n);
+			__m128 r2 = _mm_loadu_ps(yg[2] + n);
+			__m128 r3 = _mm_loadu_ps(yg[3] + n);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			__m128 sg = s4[g];
+			const __m128 dg = d4[g];
+			const __m128 eg = e4[g];
+			r0 = sg = drumkv1_simd_denormal4(_mm_add_ps(
+				_mm_mul_ps(r0, eg), _mm_mul_ps(sg, dg)));
+			r1 = sg = drumkv1_simd_denormal4(_mm_add_ps(
+				_mm_mul_ps(r1, eg), _mm_mul_ps(sg, dg)));
+			r2 = sg = drumkv1_simd_denormal4(_mm_add_ps(
+				_mm_mul_ps(r2, eg), _mm_mul_ps(sg, dg)));
+			r3 = sg = drumkv1_simd_denormal4(_mm_add_ps(
+				_mm_mul_ps(r3, eg), _mm_mul_ps(sg, dg)));
+			s4[g] = sg;
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			_mm_storeu_ps(yg[0] + n, r0);
+			_mm_storeu_ps(yg[1] + n, r1);
+			_mm_storeu_ps(yg[2] + n, r2);
+			_mm_storeu_ps(yg[3] + n, r3);
+		}
+	}
+	for (g = 0; g < ngroups; ++g)
+		_mm_storeu_ps(s + (g << 2), s4[g]);
+#endif
+	for (uint32_t k = 0; k < nlanes; ++k) {
+		float *yk = y[k];
+		const float dk = d[k];
+		const float ek = 1.0f - dk;
+		float sk = s[k];
+		for (uint32_t i = n; i < nframes; ++i) {
+			sk = drumkv1_simd_denormal(yk[i] * ek + sk * dk);
+			yk[i] = sk;
+		}
+		s[k] = sk;
+	}
+}
+
+
+// comb delay line feedback:
+//   b[n] = x[n] + z[n] * feedb
+
+inline void drumkv1_simd_comb ( float *b,
+	const float *x, const float *z, float feedb, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__SSE2__)
+	const __m128 f4 = _mm_set1_ps(feedb);
+	for (; n + 4 <= nframes; n += 4) {
+		_mm_storeu_ps(b + n, _mm_add_ps(_mm_loadu_ps(x + n),
+			_mm_mul_ps(_mm_loadu_ps(z + n), f4)));
+	}
+#endif
+	for (; n < nframes; ++n)
+		b[n] = x[n] + z[n] * feedb;
+}
+
+
+// all-pass delay line, in-place:
+//   y = b[n], b[n] = denormal(x[n] + y * feedb), x[n] = y - x[n]
+
+inline void drumkv1_simd_allpass ( float *b,
+	float *x, float feedb, uint32_t nframes )
+{
+	uint32_t n = 0;
+#if defined(__SSE2__)
+	const __m128 f4 = _mm_set1_ps(feedb);
+	for (; n + 4 <= nframes; n += 4) {
+		const __m128 x4 = _mm_loadu_ps(x + n);
+		const __m128 y4 = _mm_loadu_ps(b + n);
+		_mm_storeu_ps(b + n, drumkv1_simd_denormal4(
+			_mm_add_ps(x4, _mm_mul_ps(y4, f4))));
+		_mm_storeu_ps(x + n, _mm_sub_ps(y4, x4));
+	}
+#endif
+	for (; n < nframes; ++n) {
+		const float y = b[n];
+		b[n] = drumkv1_simd_denormal(x[n] + y * feedb);
+		x[n] = y - x[n];
+	}
+}
+
+
+//-------------------------------------------------------------------------
+// drumkv1_simd_ftz - denormals flush-to-zero (scoped; SSE2 only).
+//
+// Sets the FTZ and DAZ bits of the SSE control/status register,
+// once per processing block, restoring its former state on exit.
+//
+
+class drumkv1_simd_ftz
+{
+public:
+
+#if defined(__SSE2__)
+	drumkv1_simd_ftz() : m_csr(_mm_getcsr())
+		{ _mm_setcsr(m_csr | 0x8040); }
+	~drumkv1_simd_ftz()
+		{ _mm_setcsr(m_csr); }
+
+private:
+
+	unsigned int m_csr;
+#else
+	drumkv1_simd_ftz() {}
+#endif
+};
+
+
+#endif	// __drumkv1_simd_h
+
+// end of drumkv1_simd.h
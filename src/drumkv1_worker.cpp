@@ -0,0 +1,167 @@
+// drumkv1_worker.cpp
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "drumkv1_worker.h"
+
+#include "drumkv1_rtcheck.h"
+
+#include <errno.h>
+
+
+//-------------------------------------------------------------------------
+// drumkv1_worker - real-time worker thread pool (fork/join).
+//
+
+// ctor.
+drumkv1_worker::drumkv1_worker ( uint16_t nthreads )
+	: m_nthreads(0), m_threads(nullptr),
+		m_func(nullptr), m_arg(nullptr), m_pending(0),
+		m_policy(SCHED_OTHER), m_priority(0), m_running(true)
+{
+	::sem_init(&m_done, 0, 0);
+
+	if (nthreads > 0)
+		m_threads = new Thread [nthreads];
+
+	for (uint16_t i = 0; i < nthreads; ++i) {
+		Thread *pThread = &m_threads[m_nthreads];
+		pThread->worker = this;
+		pThread->islot = m_nthreads + 1;
+		::sem_init(&pThread->start, 0, 0);
+		if (::pthread_create(&pThread->thread, nullptr,
+				drumkv1_worker::thread_run, pThread) != 0) {
+			::sem_destroy(&pThread->start);
+			break;
+		}
+		++m_nthreads;
+	}
+}
+
+
+// dtor.
+drumkv1_worker::~drumkv1_worker (void)
+{
+	m_running = false;
+
+	for (uint16_t i = 0; i < m_nthreads; ++i)
+		::sem_post(&m_threads[i].start);
+
+	for (uint16_t i = 0; i < m_nthreads; ++i) {
+		::pthread_join(m_threads[i].thread, nullptr);
+		::sem_destroy(&m_threads[i].start);
+	}
+
+	if (m_threads)
+		delete [] m_threads;
+
+	::sem_destroy(&m_done);
+}
+
+
+// run work function on all slots (blocking).
+void drumkv1_worker::run ( WorkFunc func, void *arg )
+{
+	if (m_nthreads < 1) {
+		(*func)(arg, 0);
+		return;
+	}
+
+	start(func, arg);
+
+	(*func)(arg, 0);
+
+	wait();
+}
+
+
+// start work function on worker slots only (non-blocking).
+void drumkv1_worker::start ( WorkFunc func, void *arg )
+{
+	if (m_nthreads < 1) {
+		(*func)(arg, 0);
+		return;
+	}
+
+	sync_sched();
+
+	m_func = func;
+	m_arg  = arg;
+
+	m_pending = m_nthreads;
+
+	for (uint16_t i = 0; i < m_nthreads; ++i)
+		::sem_post(&m_threads[i].start);
+}
+
+
+// wait for started work to finish (blocking).
+void drumkv1_worker::wait (void)
+{
+	// join (bounded wait on real-time worker threads)...
+	DRUMKV1_RTCHECK_ALLOW();
+
+	for (; m_pending > 0; --m_pending) {
+		while (::sem_wait(&m_done) != 0 && errno == EINTR)
+			;
+	}
+}
+
+
+// follow caller thread's scheduling policy/priority.
+void drumkv1_worker::sync_sched (void)
+{
+	int policy = SCHED_OTHER;
+	struct sched_param param;
+
+	if (::pthread_getschedparam(::pthread_self(), &policy, &param) != 0)
+		return;
+
+	if (policy == m_policy && param.sched_priority == m_priority)
+		return;
+
+	m_policy = policy;
+	m_priority = param.sched_priority;
+
+	for (uint16_t i = 0; i < m_nthreads; ++i)
+		::pthread_setschedparam(m_threads[i].thread, m_policy, &param);
+}
+
+
+// worker thread main procedure.
+void *drumkv1_worker::thread_run ( void *arg )
+{
+	Thread *pThread = static_cast<Thread *> (arg);
+	drumkv1_worker *pWorker = pThread->worker;
+
+	for (;;) {
+		while (::sem_wait(&pThread->start) != 0 && errno == EINTR)
+			;
+		if (!pWorker->m_running)
+			break;
+		(*pWorker->m_func)(pWorker->m_arg, pThread->islot);
+		::sem_post(&pWorker->m_done);
+	}
+
+	return nullptr;
+}
+
+
+// end of drumkv1_worker.cpp
@@ -0,0 +1,110 @@
+// drumkv1_worker.h
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#ifndef __drumkv1_worker_h
+#define __drumkv1_worker_h
+
+#include <stdint.h>
+
+#include <pthread.h>
+#include <semaphore.h>
+
+
+//-------------------------------------------------------------------------
+// drumkv1_worker - real-time worker thread pool (fork/join).
+//
+// Work is run on all slots at once: slot 0 is always the calling
+// (audio) thread itself, slots 1..threads() are pre-spawned worker
+// threads that follow the caller's scheduling policy and priority.
+// Work may also be started on the worker threads only, then joined
+// later (eg. pipelined on the next audio block).
+//
+
+class drumkv1_worker
+{
+public:
+
+	// work function prototype.
+	typedef void (*WorkFunc)(void *arg, uint16_t islot);
+
+	// ctor.
+	drumkv1_worker(uint16_t nthreads = 0);
+
+	// dtor.
+	~drumkv1_worker();
+
+	// number of worker threads (besides the caller).
+	uint16_t threads() const
+		{ return m_nthreads; }
+
+	// number of work slots (worker threads plus the caller).
+	uint16_t slots() const
+		{ return m_nthreads + 1; }
+
+	// run work function on all slots (blocking).
+	void run(WorkFunc func, void *arg);
+
+	// start work function on worker slots only (non-blocking);
+	// runs on the caller (slot 0) if there are no worker threads.
+	void start(WorkFunc func, void *arg);
+
+	// wait for started work to finish (blocking).
+	void wait();
+
+protected:
+
+	// worker thread main procedure.
+	static void *thread_run(void *arg);
+
+	// follow caller thread's scheduling policy/priority.
+	void sync_sched();
+
+private:
+
+	// worker thread state.
+	struct Thread
+	{
+		drumkv1_worker *worker;
+		uint16_t islot;
+		pthread_t thread;
+		sem_t start;
+	};
+
+	uint16_t m_nthreads;
+	Thread  *m_threads;
+
+	sem_t m_done;
+
+	WorkFunc m_func;
+	void    *m_arg;
+
+	uint16_t m_pending;
+
+	int m_policy;
+	int m_priority;
+
+	volatile bool m_running;
+};
+
+
+#endif	// __drumkv1_worker_h
+
+// end of drumkv1_worker.h
@@ -1098,6 +1098,23 @@ void drumkv1widget::savePreset ( const QString& sFilename )
 }
 
 
+// Sample memory page-lock status (if enabled).
+static QString drumkv1widget_lock_status (void)
+{
+	if (!drumkv1_sample_pool::isLocking())
+		return QString();
+
+	QString sStatus = QObject::tr(" [locked: %1 MB")
+		.arg(double(drumkv1_sample_pool::lockedSize()) / double(1 << 20), 0, 'f', 1);
+	const uint32_t iFailures = drumkv1_sample_pool::lockFailures();
+	if (iFailures > 0)
+		sStatus += QObject::tr(", %1 failed").arg(iFailures);
+	sStatus += ']';
+
+	return sStatus;
+}
+
+
 // Sample reset slot.
 void drumkv1widget::clearSample (void)
 {
@@ -1116,7 +1133,8 @@ void drumkv1widget::loadSample ( const QString& sFilename )
 	loadSampleFile(info.canonicalFilePath());
 
 	m_ui.StatusBar->showMessage(
-		tr("Load sample: %1").arg(info.fileName()), 5000);
+		tr("Load sample: %1").arg(info.fileName())
+		+ drumkv1widget_lock_status(), 5000);
 	updateDirtyPreset(true);
 }
 
@@ -1648,7 +1666,8 @@ void drumkv1widget::updateLoadPreset ( const QString& sPreset )
 	updateParamValues(drumkv1::NUM_PARAMS);
 
 	m_ui.Preset->setPreset(sPreset);
-	m_ui.StatusBar->showMessage(tr("Load preset: %1").arg(sPreset), 5000);
+	m_ui.StatusBar->showMessage(tr("Load preset: %1").arg(sPreset)
+		+ drumkv1widget_lock_status(), 5000);
 	updateDirtyPreset(false);
 }
 
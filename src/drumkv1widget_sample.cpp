@@ -113,14 +113,15 @@ void drumkv1widget_sample::setSample ( drumkv1_sample *pSample )
 		m_ppPolyg = new QPolygon* [m_iChannels];
 		for (uint16_t k = 0; k < m_iChannels; ++k) {
 			m_ppPolyg[k] = new QPolygon(w);
-			const float *pframes = m_pSample->frames(k);
+			const bool bReverse = m_pSample->isReverse();
 			float vmax = 0.0f;
 			float vmin = 0.0f;
 			int n = 0;
 			int x = 1;
 			uint32_t j = 0;
 			for (uint32_t i = 0; i < nframes; ++i) {
-				const float v = *pframes++;
+				const float v = m_pSample->frame(k,
+					bReverse ? nframes - 1 - i : i);
 				if (vmax < v || j == 0)
 					vmax = v;
 				if (vmin > v || j == 0)
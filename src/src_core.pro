@@ -16,11 +16,17 @@ HEADERS = \
 	drumkv1_formant.h \
 	drumkv1_resampler.h \
 	drumkv1_sample.h \
+	drumkv1_sample_cache.h \
+	drumkv1_sample_stream.h \
 	drumkv1_wave.h \
 	drumkv1_ramp.h \
 	drumkv1_list.h \
 	drumkv1_fx.h \
 	drumkv1_reverb.h \
+	drumkv1_simd.h \
+	drumkv1_fastmath.h \
+	drumkv1_worker.h \
+	drumkv1_rtcheck.h \
 	drumkv1_param.h \
 	drumkv1_sched.h \
 	drumkv1_tuning.h \
@@ -30,12 +36,17 @@ HEADERS = \
 SOURCES = \
 	drumkv1.cpp \
 	drumkv1_config.cpp \
+	drumkv1_filter.cpp \
 	drumkv1_formant.cpp \
 	drumkv1_resampler.cpp \
 	drumkv1_sample.cpp \
+	drumkv1_sample_cache.cpp \
+	drumkv1_sample_stream.cpp \
 	drumkv1_wave.cpp \
 	drumkv1_param.cpp \
 	drumkv1_sched.cpp \
+	drumkv1_worker.cpp \
+	drumkv1_rtcheck.cpp \
 	drumkv1_tuning.cpp \
 	drumkv1_programs.cpp \
 	drumkv1_controls.cpp
@@ -0,0 +1,207 @@
+// drumkv1_test_fastmath.cpp
+//
+/****************************************************************************
+   Copyright (C) 2012-2020, rncbc aka Rui Nuno Capela. All rights reserved.
+
+   This program is free software; you can redistribute it and/or
+   modify it under the terms of the GNU General Public License
+   as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along
+   with this program; if not, write to the Free Software Foundation, Inc.,
+   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+
+*****************************************************************************/
+
+#include "drumkv1_fastmath.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+//-------------------------------------------------------------------------
+// drumkv1_test_fastmath - error bounds (as documented) against libm.
+//
+
+static const uint32_t NSTEPS = (1 << 20);
+
+static int g_failures = 0;
+
+
+// error kinds.
+enum ErrorKind { Absolute, Relative };
+
+
+// scalar and 4 lane (SSE2) function pairs.
+typedef float (*ScalarFunc)(float);
+typedef double (*RefFunc)(double);
+
+#if defined(__SSE2__)
+typedef __m128 (*VectorFunc)(__m128);
+#endif
+
+
+static double ref_exp2 ( double x ) { return ::exp2(x); }
+static double ref_exp  ( double x ) { return ::exp(x);  }
+static double ref_sin  ( double x ) { return ::sin(x);  }
+static double ref_cos  ( double x ) { return ::cos(x);  }
+static double ref_tanh ( double x ) { return ::tanh(x); }
+
+
+// error of one approximated value.
+static double test_error ( ErrorKind kind, float y, double x, RefFunc ref )
+{
+	const double y0 = ref(x);
+	const double err = ::fabs(double(y) - y0);
+	return (kind == Relative ? err / ::fabs(y0) : err);
+}
+
+
+// check one (scalar and vector) approximation over [x0, x1].
+static void test_check ( const char *name, ScalarFunc func,
+#if defined(__SSE2__)
+	VectorFunc func4,
+#endif
+	RefFunc ref, ErrorKind kind, float x0, float x1, double bound )
+{
+	double err = 0.0;
+#if defined(__SSE2__)
+	double err4 = 0.0;
+#endif
+
+	const double dx = (double(x1) - double(x0)) / double(NSTEPS);
+	for (uint32_t i = 0; i <= NSTEPS; i += 4) {
+		float x[4];
+		for (uint32_t j = 0; j < 4; ++j) {
+			x[j] = float(double(x0) + double(i + j) * dx);
+			if (x[j] > x1)
+				x[j] = x1;
+			const double e = test_error(kind, func(x[j]), x[j], ref);
+			if (e > err || e != e)
+				err = e;
+		}
+	#if defined(__SSE2__)
+		float y[4];
+		_mm_storeu_ps(y, func4(_mm_loadu_ps(x)));
+		for (uint32_t j = 0; j < 4; ++j) {
+			const double e = test_error(kind, y[j], x[j], ref);
+			if (e > err4 || e != e)
+				err4 = e;
+		}
+	#endif
+	}
+
+	const char *kinds = (kind == Relative ? "rel" : "abs");
+
+	const bool ok = (err < bound);
+	::printf("%-8s [%+9.4f, %+9.4f] %s error %.3e < %.1e  %s\n",
+		name, x0, x1, kinds, err, bound, ok ? "ok" : "FAILED");
+	if (!ok)
+		++g_failures;
+
+#if defined(__SSE2__)
+	const bool ok4 = (err4 < bound);
+	::printf("%-8s [%+9.4f, %+9.4f] %s error %.3e < %.1e  %s\n",
+		"  (sse2)", x0, x1, kinds, err4, bound, ok4 ? "ok" : "FAILED");
+	if (!ok4)
+		++g_failures;
+#endif
+}
+
+
+#if defined(__SSE2__)
+#define TEST_CHECK(name, func, ref, kind, x0, x1, bound) \
+	test_check(name, func, func##4, ref, kind, x0, x1, bound)
+#else
+#define TEST_CHECK(name, func, ref, kind, x0, x1, bound) \
+	test_check(name, func, ref, kind, x0, x1, bound)
+#endif
+
+
+// tanh has no vector variant.
+static void test_tanh ( float x0, float x1, double bound )
+{
+	double err = 0.0;
+
+	const double dx = (double(x1) - double(x0)) / double(NSTEPS);
+	for (uint32_t i = 0; i <= NSTEPS; ++i) {
+		const float x = float(double(x0) + double(i) * dx);
+		const double e = test_error(Absolute, drumkv1_fast_tanhf(x), x, ref_tanh);
+		if (e > err || e != e)
+			err = e;
+	}
+
+	const bool ok = (err < bound);
+	::printf("%-8s [%+9.4f, %+9.4f] abs error %.3e < %.1e  %s\n",
+		"tanhf", x0, x1, err, bound, ok ? "ok" : "FAILED");
+	if (!ok)
+		++g_failures;
+}
+
+
+// block sigmoid kernel, against its (scalar) formula.
+static void test_sigmoid ( double bound )
+{
+	const uint32_t nframes = 1027;	// odd, on purpose (scalar tail).
+
+	float y[nframes];
+	for (uint32_t n = 0; n < nframes; ++n)
+		y[n] = -0.5f + 2.0f * float(n) / float(nframes - 1);
+
+	float x[nframes];
+	::memcpy(x, y, sizeof(x));
+
+	drumkv1_fast_sigmoid_1(y, nframes);
+
+	double err = 0.0;
+	for (uint32_t n = 0; n < nframes; ++n) {
+		double u = 2.0 * double(x[n]) - 1.0;
+		if (u < -1.0)
+			u = -1.0;
+		else
+		if (u > +1.0)
+			u = +1.0;
+		const double y0 = 0.5 * (1.0 + 0.99 * u * (1.5 - 0.5 * u * u));
+		const double e = ::fabs(double(y[n]) - y0);
+		if (e > err || e != e)
+			err = e;
+	}
+
+	const bool ok = (err < bound);
+	::printf("%-8s [%+9.4f, %+9.4f] abs error %.3e < %.1e  %s\n",
+		"sigmoid", -0.5f, +1.5f, err, bound, ok ? "ok" : "FAILED");
+	if (!ok)
+		++g_failures;
+}
+
+
+int main ( int, char ** )
+{
+	const float PI = 3.14159265f;
+
+	TEST_CHECK("exp2f", drumkv1_fast_exp2f, ref_exp2, Relative, -126.0f, +126.0f, 3e-7);
+	TEST_CHECK("exp2f", drumkv1_fast_exp2f, ref_exp2, Relative,   -1.0f,   +1.0f, 3e-7);
+	TEST_CHECK("expf",  drumkv1_fast_expf,  ref_exp,  Relative,  -87.0f,  +87.0f, 5e-6);
+	TEST_CHECK("expf",  drumkv1_fast_expf,  ref_exp,  Relative,   -8.0f,   +8.0f, 8e-7);
+	TEST_CHECK("sinf",  drumkv1_fast_sinf,  ref_sin,  Absolute, -2.0f * PI, +2.0f * PI, 4e-7);
+	TEST_CHECK("sinf",  drumkv1_fast_sinf,  ref_sin,  Absolute, -4.0f * PI, +4.0f * PI, 6e-7);
+	TEST_CHECK("cosf",  drumkv1_fast_cosf,  ref_cos,  Absolute, -2.0f * PI, +2.0f * PI, 4e-7);
+	TEST_CHECK("cosf",  drumkv1_fast_cosf,  ref_cos,  Absolute, -4.0f * PI, +4.0f * PI, 6e-7);
+
+	test_tanh(-8.0f, +8.0f, 0.025);
+	test_sigmoid(1e-6);
+
+	if (g_failures > 0)
+		::printf("%d failure(s).\n", g_failures);
+
+	return (g_failures > 0 ? 1 : 0);
+}
+
+
+// end of drumkv1_test_fastmath.cpp